@@ -10,16 +10,21 @@
 #pragma once
 #include <algorithm>
 #include <cctype>
+#include <chrono>
 #include <fstream>
+#include <limits>
 #include <map>
 #include <random>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <type_traits>
 
 #include "action.h"
 #include "board.h"
 #include "mcts/mcts.h"
+#include "solver/region.h"
+#include "solver/solver.h"
 
 class agent {
  public:
@@ -98,9 +103,10 @@ class player : public random_agent {
 
   virtual action take_action(const board& state) {
     std::shuffle(space.begin(), space.end(), engine);
+    if (state.info().who_take_turns != who) return action();
+    board::bitboard legal = state.legal_moves(who);
     for (const action::place& move : space) {
-      board after = state;
-      if (move.apply(after) == board::legal) return move;
+      if (legal & board::bit(move.position().i)) return move;
     }
     return action();
   }
@@ -114,43 +120,386 @@ class MCTSAgent : public agent {
  public:
   MCTSAgent(const std::string& args = "")
       : agent("name=MCTSAgent role=unknown " + args) {
-    if (meta.find("T") != meta.end()) {
-      simulation_count = (int(meta["T"]));
+    if (meta.find("timeout") != meta.end()) timeout = int(meta["timeout"]);
+    if (meta.find("game_time") != meta.end())
+      game_time = int(meta["game_time"]);
+    if (timeout > 0 || game_time > 0)
+      options.simulation_count = std::numeric_limits<int>::max();
+    if (meta.find("T") != meta.end()) {  // overrides the time limits
+      options.simulation_count = (int(meta["T"]));
+      timeout = game_time = 0;
     }
+    int threads = 1;
+    if (meta.find("threads") != meta.end())
+      threads = std::max(1, int(meta["threads"]));
+    bool shared = meta.find("parallel") != meta.end() &&
+                  std::string(meta["parallel"]) == "tree";
+    if (shared) {
+      options.simulation_count = (options.simulation_count - 1) / threads + 1;
+      options.threads = threads;
+      options.virtual_loss = 1;
+    }
+    if (meta.find("virtual_loss") != meta.end())
+      options.virtual_loss = int(meta["virtual_loss"]);
+    if (meta.find("playouts") != meta.end())
+      options.playouts = std::max(1, int(meta["playouts"]));
+    std::string policy = "ucb1";
+    if (meta.find("rave") != meta.end()) {  // implies policy=rave
+      options.rave = double(meta["rave"]);
+      policy = "rave";
+    }
+    if (meta.find("rave_bias") != meta.end()) {
+      options.rave_bias = double(meta["rave_bias"]);
+      policy = "rave";
+    }
+    if (meta.find("c_puct") != meta.end())
+      options.c_puct = double(meta["c_puct"]);
+    if (meta.find("policy") != meta.end()) policy = std::string(meta["policy"]);
+    mcts = GetSearch<NoGoState>(policy);
+    if (meta.find("table") != meta.end()) {  // in megabytes
+      table.reset(new TranspositionTable(size_t(meta["table"]) << 20));
+      options.table = table.get();
+    }
+    if (meta.find("solve") != meta.end()) solve = int(meta["solve"]);
+    if (meta.find("solve_time") != meta.end())
+      solve_time = int(meta["solve_time"]);
+    if (solve > 0) solver.reset(new Solver());
+    if (meta.find("regions") != meta.end()) regions = int(meta["regions"]);
+    if (regions > 0) region_solver.reset(new RegionSolver(regions));
+    if (meta.find("ponder") != meta.end()) ponder = int(meta["ponder"]);
+    options.minmax = true;
+    unsigned seed = 0;
+    if (meta.find("seed") != meta.end()) seed = int(meta["seed"]);
+    trees.resize(shared ? 1 : threads);
+    if (meta.find("memory") != meta.end()) {  // in megabytes, for all trees
+      size_t bytes = size_t(meta["memory"]) << 20;
+      options.node_limit = std::max<size_t>(
+          1, bytes / (NodePool::NodeBytes() * 2 * trees.size()));
+    }
+    engines.resize(threads);
+    for (int i = 0; i < threads; i++) engines[i].seed(seed + i);
     if (role() == "black") who = board::black;
     if (role() == "white") who = board::white;
     if (who == board::empty)
       throw std::invalid_argument("invalid role: " + role());
   }
 
-  virtual void open_episode(const std::string& flag = "") { root_init = false; }
+  virtual ~MCTSAgent() { stop_pondering(); }
+
+  virtual void open_episode(const std::string& flag = "") {
+    stop_pondering();
+    for (auto& tree : trees) tree.root = kNullNode;
+    if (table) table->Clear();
+    if (solver) solver->Clear();
+    if (region_solver) region_solver->Clear();
+    time_left = game_time;
+  }
 
+  /**
+   * search the position with one independent tree per thread, or with one
+   * tree shared by all threads if parallel=tree, where each tree runs the
+   * given number of simulations, and play the most visited action over all
+   * trees
+   *
+   * with ponder=1, the search goes on in the background after our move,
+   * until the next move is asked for or the opponent's move is notified
+   */
   virtual action take_action(const board& state) {
+    stop_pondering();
+    action move = think(state);
+    if (ponder && move.type() == action::place::type)
+      start_pondering(state, move);
+    return move;
+  }
+
+  virtual void close_episode(const std::string& flag = "") {
+    stop_pondering();
+    for (auto& tree : trees) tree.root = kNullNode;
+  }
+
+  /**
+   * move the roots down through the action, unless it is our own action
+   * that the roots already followed when pondering started, or it is not
+   * the turn of its side at the roots, e.g., the opponent's reply to a move
+   * the roots have not followed without pondering; reuse then catches up by
+   * comparing the boards in the next take_action
+   */
+  virtual void notify_action(const action& a) {
+    stop_pondering();
+    if (a.type() == action::place::type) {
+      action::place move(a);
+      board::bitboard stones = root_board.mask(move.color());
+      if (stones & board::bit(move.position().i)) return;
+      if (move.color() != root_board.info().who_take_turns) return;
+    }
+    follow(a);
+  }
+
+ protected:
+  /**
+   * pick the action for the position, see take_action
+   */
+  action think(const board& state) {
+    auto& moves = state.legal_set(who);
+    if (moves.size() == 1) return action::place(moves[0], who);
+
+    auto start = std::chrono::steady_clock::now();
     NoGoState no_go_state(state);
-    if (root_init == false) {
-      CreateRootNode(no_go_state);
-      root_init = true;
-    } else {
-      root = root->FindChild(no_go_state);
+    reuse(state);
+    for (auto& tree : trees) {
+      if (tree.root != kNullNode) continue;
+      tree.pool.Clear();
+      tree.root = CreateRootNode(tree.pool, no_go_state);
     }
 
-    int act = MCTS(root, simulation_count, true);
+    /* the solvers come first, and the search gets the time they leave */
+    SearchOptions search = options;
+    int budget = allocate_time(state);
+    search.timeout = budget;
+    auto elapsed = [&]() -> int {
+      return std::chrono::duration_cast<std::chrono::milliseconds>(
+                 std::chrono::steady_clock::now() - start)
+          .count();
+    };
+    if (region_solver) {  // sum up the regions if they are all small
+      auto result = region_solver->Solve(
+          state, (budget > 0 ? budget : solve_time) / 2);
+      if (result.solved && result.win) {
+        time_left -= elapsed();
+        return action::place(result.move, who);
+      }
+      if (budget > 0) search.timeout = std::max(1, budget - elapsed());
+    }
+    if (solver && int(moves.size()) < solve) {  // hand the endgame over
+      auto result = solver->Search(
+          state, 0, search.timeout > 0 ? search.timeout : solve_time);
+      if (result.proven && result.score > 0) {
+        time_left -= elapsed();
+        return action::place(result.move, who);
+      }
+      if (budget > 0) search.timeout = std::max(1, budget - elapsed());
+    }
+#pragma omp parallel for num_threads(engines.size())
+    for (int i = 0; i < int(engines.size()); i++) {
+      auto& tree = trees[i % trees.size()];
+      mcts(tree.pool, tree.root, no_go_state, engines[i], search);
+    }
+    int act = best_action();
+    time_left -= std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+    report_memory();
     if (act == -1) return action();
     return action::place(act, who);
   }
 
-  virtual void close_episode(const std::string& flag = "") {
-    root_init = false;
+  /**
+   * the milliseconds to search for this move, which is the timeout if given,
+   * or a share of the time left in the game otherwise
+   *
+   * the share is the time left divided by our expected number of remaining
+   * moves, i.e., about half of our legal moves, and is reduced in the opening
+   * where the choices matter less
+   */
+  int allocate_time(const board& state) const {
+    if (game_time <= 0) return timeout;
+    int played = board::count(state.mask(board::black) |
+                              state.mask(board::white));
+    double moves_left = std::max(4.0, state.legal_set(who).size() / 2.0);
+    double share = time_left / moves_left;
+    if (played < 10) share *= 0.5 + played / 20.0;
+    int budget = std::max(1, int(share));
+    return timeout > 0 ? std::min(timeout, budget) : budget;
   }
 
-  virtual void notify_action(const action& a) {}
+  /**
+   * the action proven to win in any tree, or else the action whose root kid
+   * has the most visits summed over all trees, avoiding the actions proven
+   * to lose while there are others
+   */
+  int best_action() const {
+    std::array<uint64_t, board::size_x * board::size_y> visits = {};
+    std::array<bool, board::size_x * board::size_y> losing = {};
+    for (auto& tree : trees) {
+      const Node& root = tree.pool[tree.root];
+      for (NodeId kid = root.kids; kid < root.kids + root.kid_count; ++kid) {
+        int8_t proof = tree.pool[kid].proof;
+        if (proof == Node::kLoss) return tree.pool[kid].action;
+        if (proof == Node::kWin) losing[tree.pool[kid].action] = true;
+        visits[tree.pool[kid].action] += tree.pool.Visits(kid);
+      }
+    }
+    int best = -1;
+    for (int i = 0; i < int(visits.size()); i++) {
+      if (!visits[i]) continue;
+      if (best == -1 || (losing[best] && !losing[i]) ||
+          (losing[best] == losing[i] && visits[i] > visits[best]))
+        best = i;
+    }
+    return best;
+  }
+
+  /**
+   * move the roots down through an action played at their position, and
+   * drop the trees where that action has not been searched
+   * return whether the action is legal at the position of the roots
+   */
+  bool follow(const action& a) {
+    bool legal = a.type() == action::place::type &&
+                 a.apply(root_board) == board::legal;
+    int move = action::place(a).position().i;
+    for (auto& tree : trees) {
+      if (tree.root == kNullNode) continue;
+      tree.root = legal ? tree.pool.FindChild(tree.root, move) : kNullNode;
+    }
+    return legal;
+  }
+
+  /**
+   * publish the nodes in use and the megabytes held by all trees, as the
+   * properties nodes_used and memory_used
+   */
+  void report_memory() {
+    size_t nodes = 0, bytes = 0;
+    for (auto& tree : trees) {
+      nodes += tree.pool.Size();
+      bytes += tree.pool.Bytes() + tree.spare.Bytes();
+    }
+    notify("nodes_used=" + std::to_string(nodes));
+    notify("memory_used=" + std::to_string(bytes >> 20));
+  }
+
+  /**
+   * follow our action, and keep searching the position after it on another
+   * thread, so that the opponent's thinking time is not wasted; the roots
+   * are then moved down through the opponent's action by notify_action, or
+   * by reuse in the next take_action
+   */
+  void start_pondering(const board& state, const action& move) {
+    reuse(state);
+    if (!follow(move)) return;
+    if (root_board.legal_set().empty()) return;  // the game is over
+    halt = false;
+    pondering = std::thread([this]() {
+      NoGoState no_go_state(root_board);
+      for (auto& tree : trees) {
+        if (tree.root != kNullNode) continue;
+        tree.pool.Clear();
+        tree.root = CreateRootNode(tree.pool, no_go_state);
+      }
+      SearchOptions search = options;
+      search.simulation_count = std::numeric_limits<int>::max();
+      search.timeout = 0;
+      search.stop = &halt;
+#pragma omp parallel for num_threads(engines.size())
+      for (int i = 0; i < int(engines.size()); i++) {
+        auto& tree = trees[i % trees.size()];
+        mcts(tree.pool, tree.root, no_go_state, engines[i], search);
+      }
+    });
+  }
+
+  void stop_pondering() {
+    if (!pondering.joinable()) return;
+    halt = true;
+    pondering.join();
+  }
+
+  /**
+   * follow the moves played since the roots, i.e., ours and the opponent's,
+   * and keep only the subtrees of the given position
+   */
+  void reuse(const board& state) {
+    while (root_board != state) {
+      auto turn = root_board.info().who_take_turns;
+      board::bitboard fresh = state.mask(turn) & ~root_board.mask(turn);
+      if (board::count(fresh) != 1) break;
+      if (!follow(action::place(board::lowest(fresh), turn))) break;
+    }
+    if (root_board != state ||
+        root_board.info().who_take_turns != state.info().who_take_turns) {
+      for (auto& tree : trees) tree.root = kNullNode;
+      root_board = state;
+    }
+
+    /*
+     * the discarded part is released at once by clearing the other pool,
+     * and under a node limit, at most half of it is kept, dropping the least
+     * visited subtrees, so that the search has room to grow
+     */
+    size_t keep = options.node_limit / 2;
+    for (auto& tree : trees) {
+      if (tree.root == kNullNode) continue;
+      bool moved = tree.pool[tree.root].parent != kNullNode;
+      if (!moved && (!keep || tree.pool.Size() <= keep)) continue;
+      tree.spare.Clear();
+      tree.root = tree.spare.CopySubtree(tree.pool, tree.root, keep);
+      std::swap(tree.pool, tree.spare);
+    }
+  }
 
  private:
-  int simulation_count = 100;
+  SearchOptions options;
+  SearchFunction<NoGoState> mcts;  // MCTS with the selection policy in use
+  int timeout = 0;    // the milliseconds for each move
+  int game_time = 0;  // the milliseconds for each game
+  int64_t time_left = 0;
   board::piece_type who;
 
-  MCTSNodePtr root;
-  bool root_init = false;
+  struct tree {
+    NodePool pool;
+    NodePool spare;
+    NodeId root = kNullNode;
+  };
+  std::vector<tree> trees;
+  std::vector<Random> engines;  // one for each thread
+  std::unique_ptr<TranspositionTable> table;         // shared by all trees
+  std::unique_ptr<Solver> solver;  // for the endgame, if solve > 0
+  int solve = 14;          // solve exactly below this many legal moves
+  int solve_time = 1000;   // the milliseconds to try, without a timeout
+  std::unique_ptr<RegionSolver> region_solver;  // if regions > 0
+  int regions = 12;  // the largest region to solve by decomposition
+  board root_board;  // the position of the roots
+  bool ponder = false;           // search on during the opponent's turn
+  std::thread pondering;         // the background search, if running
+  std::atomic<bool> halt{false};  // tells the background search to stop
+};
+
+/**
+ * alpha-beta player, which deepens its search until the game is solved or
+ * depth=<plies> is reached, judging by the difference in mobility at the
+ * horizon, within timeout=<milliseconds> for each move (1000 by default if
+ * the depth is unlimited), with a transposition table of table=<megabytes>
+ */
+class AlphaBetaAgent : public agent {
+ public:
+  AlphaBetaAgent(const std::string& args = "")
+      : agent("name=AlphaBetaAgent role=unknown " + args), who(board::empty) {
+    if (meta.find("depth") != meta.end()) depth = int(meta["depth"]);
+    if (meta.find("timeout") != meta.end()) timeout = int(meta["timeout"]);
+    else if (depth == 0) timeout = 1000;
+    size_t megabytes = 64;
+    if (meta.find("table") != meta.end()) megabytes = size_t(meta["table"]);
+    solver.reset(new Solver(megabytes << 20));
+    if (role() == "black") who = board::black;
+    if (role() == "white") who = board::white;
+    if (who == board::empty)
+      throw std::invalid_argument("invalid role: " + role());
+  }
+
+  virtual void open_episode(const std::string& flag = "") { solver->Clear(); }
+
+  virtual action take_action(const board& state) {
+    if (state.legal_set(who).empty()) return action();
+    int plies = depth > 0 ? depth : Solver::kMaxPlies;
+    return action::place(solver->Search(state, plies, timeout).move, who);
+  }
+
+ private:
+  std::unique_ptr<Solver> solver;
+  int depth = 0;  // 0 for no limit
+  int timeout = 0;
+  board::piece_type who;
 };
 
 agent* make_agent(const std::string& args = "") {
@@ -178,6 +527,8 @@ agent* make_agent(const std::string& args = "") {
     return new player(args);
   } else if (type == "mcts") {
     return new MCTSAgent(args);
+  } else if (type == "alphabeta" || type == "alpha-beta") {
+    return new AlphaBetaAgent(args);
   }
   return nullptr;
 }
\ No newline at end of file
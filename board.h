@@ -11,9 +11,10 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstdint>
 #include <iomanip>
 #include <iostream>
-#include <list>
+#include <string>
 #include <utility>
 
 /**
@@ -41,10 +42,159 @@
  *
  * for 9x9 Hollow NoGo, the empty locations are hollow but not empty, cannot be
  * counted as liberty, i.e., there are also borders at the center of the board
+ *
+ * internally, each kind of piece is kept as a bitboard, i.e., a mask packed
+ * into a 128-bit word where bit (i) stands for the 1-d array style position
+ * (i), so that blocks, liberties, and legal moves are computed by shifts and
+ * masks
+ *
+ * the blocks are also tracked incrementally: the stones of a block are linked
+ * as a circular list, each stone knows the anchor of its block, and the anchor
+ * keeps the size and the liberties (as a bitboard) of the block; since stones
+ * are never taken in NoGo, blocks only merge and never split
+ *
+ * the legal moves of both sides are kept as well, and after each move only
+ * the positions whose legality may change are checked again, i.e., the
+ * neighbors of the move and the liberties of the blocks next to it
+ *
+ * a 64-bit Zobrist key of the stones and the side to move is also updated
+ * by each move, see hash(); in fact one key is kept for each of the 8
+ * symmetric variants of the position, so that the canonical key among them is
+ * available without transforming the board, see canonical()
+ *
+ * the board is a template over its width, height, and hollow pattern, so that
+ * the geometry (edge masks, neighbors, hollow cells, symmetries, and Zobrist
+ * keys) is built as tables at compile time; the board in use is given by the
+ * typedef at the end of this file
+ */
+
+/**
+ * a list of indices 0, 1, ..., n - 1 for building tables at compile time
+ */
+template <unsigned... i>
+struct index_list {};
+template <unsigned n, unsigned... i>
+struct make_index_list : make_index_list<n - 1, n - 1, i...> {};
+template <unsigned... i>
+struct make_index_list<0, i...> {
+  typedef index_list<i...> type;
+};
+
+/**
+ * the hollow cells of Hollow NoGo, which lie on the center column and row,
+ * at least 2 but less than half the size away from the center (see above)
+ */
+struct hollow_cross {
+  static constexpr bool at(unsigned x, unsigned y, unsigned w, unsigned h) {
+    return (x == w / 2 && apart(y, h / 2)) || (y == h / 2 && apart(x, w / 2));
+  }
+  static constexpr bool apart(unsigned a, unsigned c) {
+    return (a > c ? a - c : c - a) >= 2 && (a > c ? a - c : c - a) < c;
+  }
+};
+
+/**
+ * no hollow cells, i.e., the plain NoGo
  */
-class board {
+struct hollow_none {
+  static constexpr bool at(unsigned, unsigned, unsigned, unsigned) {
+    return false;
+  }
+};
+
+/**
+ * the geometry of a width x height board as constexpr functions, where bit (i)
+ * stands for the position [i / height][i % height]
+ */
+template <unsigned width, unsigned height, typename hollow_pattern>
+struct board_geometry {
+  typedef unsigned __int128 bitboard;
+  static_assert(width * height < 128, "a board must fit in a bitboard");
+  static_assert(width == height, "symmetries need a square board");
+
+  static constexpr bitboard bit(unsigned i) { return bitboard(1) << i; }
+  static constexpr bitboard full() {
+    return (bitboard(1) << (width * height)) - 1;
+  }
+  static constexpr bitboard edge_down() {  // the cells with y == 0
+    return full() / ((bitboard(1) << height) - 1);
+  }
+  static constexpr bitboard edge_up() {  // the cells with y == height - 1
+    return edge_down() << (height - 1);
+  }
+  static constexpr bitboard neighbors(bitboard b) {
+    return (((b & ~edge_up()) << 1) | ((b & ~edge_down()) >> 1) |
+            (b << height) | (b >> height)) &
+           full();
+  }
+  static constexpr bitboard hollow(unsigned i = 0) {
+    return i < width * height
+               ? (hollow_pattern::at(i / height, i % height, width, height)
+                      ? bit(i)
+                      : 0) |
+                     hollow(i + 1)
+               : 0;
+  }
+  template <unsigned... i>
+  static constexpr std::array<bitboard, sizeof...(i)> adjacency(
+      index_list<i...>) {
+    return {{neighbors(bit(i))...}};
+  }
+
+  /**
+   * the position (i) after symmetry s, see basic_board::symmetric()
+   */
+  static constexpr unsigned symmetric(unsigned i, unsigned s) {
+    return rotated(s & 4 ? (width - 1 - i / height) * height + i % height : i,
+                   s & 3);
+  }
+  static constexpr unsigned rotated(unsigned i, unsigned r) {  // clockwise
+    return r ? rotated(i % height * height + (height - 1 - i / height), r - 1)
+             : i;
+  }
+
+  /**
+   * the k-th output of splitmix64 seeded with 0, so the keys are fixed
+   * the keys of black stones come first, then white stones, then the turn
+   */
+  static constexpr uint64_t splitmix64(uint64_t k) {
+    return mix(mix(mix(k * 0x9e3779b97f4a7c15ull, 30) * 0xbf58476d1ce4e5b9ull,
+                   27) *
+                   0x94d049bb133111ebull,
+               31);
+  }
+  static constexpr uint64_t mix(uint64_t z, unsigned shift) {
+    return z ^ (z >> shift);
+  }
+  static constexpr uint64_t stone_key(unsigned who, unsigned i) {
+    return who ? splitmix64((who - 1) * width * height + i + 1) : 0;
+  }
+  static constexpr uint64_t turn_key() {
+    return splitmix64(2 * width * height + 1);
+  }
+  static constexpr std::array<uint64_t, 8> stone_keys(unsigned who,
+                                                      unsigned i) {
+    return {{stone_key(who, symmetric(i, 0)), stone_key(who, symmetric(i, 1)),
+             stone_key(who, symmetric(i, 2)), stone_key(who, symmetric(i, 3)),
+             stone_key(who, symmetric(i, 4)), stone_key(who, symmetric(i, 5)),
+             stone_key(who, symmetric(i, 6)), stone_key(who, symmetric(i, 7))}};
+  }
+  template <unsigned... i>
+  static constexpr std::array<std::array<uint64_t, 8>, sizeof...(i)> zobrist(
+      unsigned who, index_list<i...>) {
+    return {{stone_keys(who, i)...}};
+  }
+};
+
+template <unsigned width, unsigned height, typename hollow_pattern>
+class basic_board {
  public:
-  enum size { size_x = 9u, size_y = 9u, hollow_x = 3u, hollow_y = 3u };
+  enum size {
+    size_x = width,
+    size_y = height,
+    hollow_x = width / 3u,
+    hollow_y = height / 3u
+  };
   enum piece_type {
     empty = 0u,
     black = 1u,
@@ -55,6 +205,10 @@ class board {
   typedef uint32_t cell;
   typedef std::array<cell, size_y> column;
   typedef std::array<column, size_x> grid;
+  typedef unsigned __int128 bitboard;
+  typedef std::array<bitboard, 4> layers;  // indexed by piece_type
+  typedef board_geometry<width, height, hollow_pattern> geometry;
+  class move_set;
   struct data {
     piece_type who_take_turns;
   };
@@ -62,10 +216,28 @@ class board {
   typedef int reward;
 
  public:
-  board() : stone(initial()), attr({piece_type::black}) {}
-  board(const grid& b, const data& d) : stone(b), attr(d) {}
-  board(const board& b) = default;
-  board& operator=(const board& b) = default;
+  basic_board()
+      : stone(initial),
+        attr({piece_type::black}),
+        block_of(),
+        block_link(),
+        block_size(),
+        block_liberty(),
+        playable(initial_playable()),
+        keys() {}
+  basic_board(const grid& b, const data& d)
+      : stone(),
+        attr(d),
+        block_of(),
+        block_link(),
+        block_size(),
+        block_liberty(),
+        keys() {
+    for (int i = 0; i < size_x * size_y; i++) set(i, b[i / size_y][i % size_y]);
+    rebuild();
+  }
+  basic_board(const basic_board& b) = default;
+  basic_board& operator=(const basic_board& b) = default;
 
   struct point {
     int x, y, i;
@@ -89,41 +261,154 @@ class board {
     }
   };
 
-  operator grid&() { return stone; }
-  operator const grid&() const { return stone; }
-  column& operator[](unsigned x) { return stone[x]; }
-  const column& operator[](unsigned x) const { return stone[x]; }
-  cell& operator()(unsigned i) {
-    point p(i);
-    return stone[p.x][p.y];
-  }
-  const cell& operator()(unsigned i) const {
-    point p(i);
-    return stone[p.x][p.y];
+  /**
+   * proxies for accessing the cells as if the board were still a grid
+   */
+  class cell_ref {
+   public:
+    cell_ref(basic_board& b, unsigned i) : b(b), i(i) {}
+    operator cell() const { return b.at(i); }
+    cell_ref& operator=(cell who) {
+      b.set(i, who);
+      b.rebuild();
+      return *this;
+    }
+    cell_ref& operator=(const cell_ref& r) { return operator=(cell(r)); }
+
+   private:
+    basic_board& b;
+    unsigned i;
+  };
+  class column_ref {
+   public:
+    column_ref(basic_board& b, unsigned x) : b(b), x(x) {}
+    cell_ref operator[](unsigned y) { return cell_ref(b, x * size_y + y); }
+    cell operator[](unsigned y) const { return b.at(x * size_y + y); }
+
+   private:
+    basic_board& b;
+    unsigned x;
+  };
+  class const_column_ref {
+   public:
+    const_column_ref(const basic_board& b, unsigned x) : b(b), x(x) {}
+    cell operator[](unsigned y) const { return b.at(x * size_y + y); }
+
+   private:
+    const basic_board& b;
+    unsigned x;
+  };
+
+  operator grid() const {
+    grid g;
+    for (int i = 0; i < size_x * size_y; i++) g[i / size_y][i % size_y] = at(i);
+    return g;
   }
-  cell& operator()(const std::string& move) {
-    point p(move);
-    return stone[p.x][p.y];
+  column_ref operator[](unsigned x) { return column_ref(*this, x); }
+  const_column_ref operator[](unsigned x) const {
+    return const_column_ref(*this, x);
   }
-  const cell& operator()(const std::string& move) const {
-    point p(move);
-    return stone[p.x][p.y];
+  cell_ref operator()(unsigned i) { return cell_ref(*this, i); }
+  cell operator()(unsigned i) const { return at(i); }
+  cell_ref operator()(const std::string& move) {
+    return cell_ref(*this, point(move).i);
   }
+  cell operator()(const std::string& move) const { return at(point(move).i); }
+
+  /**
+   * the bitboard of the given piece type
+   */
+  bitboard mask(unsigned who) const { return stone[who]; }
+
+  /**
+   * a set of positions kept as both a bitboard and a dense list, which
+   * supports insertion and removal in O(1) without allocation
+   */
+  class move_set {
+   public:
+    move_set() : bits(0), num(0), list(), slot() {}
+    bitboard mask() const { return bits; }
+    size_t size() const { return num; }
+    bool empty() const { return num == 0; }
+    bool contains(int i) const { return bits & bit(i); }
+    int operator[](size_t k) const { return list[k]; }
+    const uint8_t* begin() const { return list.data(); }
+    const uint8_t* end() const { return list.data() + num; }
+
+    void insert(int i) {
+      if (contains(i)) return;
+      slot[i] = num;
+      list[num++] = i;
+      bits |= bit(i);
+    }
+    void erase(int i) {
+      if (!contains(i)) return;
+      uint8_t last = list[--num];
+      list[slot[i]] = last;
+      slot[last] = slot[i];
+      bits &= ~bit(i);
+    }
+
+   private:
+    bitboard bits;
+    uint8_t num;
+    std::array<uint8_t, size_x * size_y> list;
+    std::array<uint8_t, size_x * size_y> slot;
+  };
 
   data info() const { return attr; }
   data info(data dat) {
     data old = attr;
     attr = dat;
+    uint64_t turn =
+        zobrist_turn(old.who_take_turns) ^ zobrist_turn(attr.who_take_turns);
+    for (uint64_t& key : keys) key ^= turn;
     return old;
   }
 
+  /**
+   * the Zobrist key of the position, including the side to move
+   * given a symmetry s, return the key of the position transformed by s
+   */
+  uint64_t hash(int s = 0) const { return keys[s]; }
+
+  /**
+   * the key of the position after the side to move places a stone at i,
+   * without placing it
+   */
+  uint64_t hash_after(int i) const {
+    return keys[0] ^ zobrist[attr.who_take_turns][i][0] ^ zobrist_white;
+  }
+
+  /**
+   * the smallest key among the 8 symmetric variants of the position, and the
+   * symmetry that transforms this position into that variant
+   */
+  std::pair<uint64_t, int> canonical() const {
+    int best = 0;
+    for (int s = 1; s < 8; s++)
+      if (keys[s] < keys[best]) best = s;
+    return std::make_pair(keys[best], best);
+  }
+
+  /**
+   * the position p after symmetry s, where s & 3 is the number of clockwise
+   * rotations, and s & 4 indicates a horizontal reflection before rotating
+   */
+  static point symmetric(const point& p, int s) {
+    return point(geometry::symmetric(p.i, s));
+  }
+  static int symmetric_inverse(int s) {  // reflections are their own inverse
+    return s & 4 ? s : (4 - s) & 3;
+  }
+
  public:
-  bool operator==(const board& b) const { return stone == b.stone; }
-  bool operator<(const board& b) const { return stone < b.stone; }
-  bool operator!=(const board& b) const { return !(*this == b); }
-  bool operator>(const board& b) const { return b < *this; }
-  bool operator<=(const board& b) const { return !(b < *this); }
-  bool operator>=(const board& b) const { return !(*this < b); }
+  bool operator==(const basic_board& b) const { return stone == b.stone; }
+  bool operator<(const basic_board& b) const { return stone < b.stone; }
+  bool operator!=(const basic_board& b) const { return !(*this == b); }
+  bool operator>(const basic_board& b) const { return b < *this; }
+  bool operator<=(const basic_board& b) const { return !(b < *this); }
+  bool operator>=(const basic_board& b) const { return !(*this < b); }
 
  public:
   enum nogo_move_result {
@@ -143,102 +428,144 @@ class board {
    * nogo_move_result::illegal_* if not
    */
   reward place(int x, int y, unsigned who = piece_type::unknown) {
-    if (who == -1u) who = attr.who_take_turns;
-    if (who != attr.who_take_turns) return nogo_move_result::illegal_turn;
-    if (x == -1 && y == -1) return nogo_move_result::illegal_pass;
-    point p_min(0, 0), p_max(size_x - 1, size_y - 1);
-    if (x < p_min.x || x > p_max.x || y < p_min.y || y > p_max.y)
-      return nogo_move_result::illegal_out_of_range;
-    if (board::initial()[x][y] == piece_type::hollow)
-      return nogo_move_result::illegal_out_of_range;
-    board test = *this;
-    if (test[x][y] != piece_type::empty)
-      return nogo_move_result::illegal_not_empty;
-    test[x][y] = who;  // try put a piece first
-    if (test.check_liberty(x, y, who) == 0)
-      return nogo_move_result::illegal_suicide;
-    unsigned opp = 3u - who;
-    if (x > p_min.x && test.check_liberty(x - 1, y, opp) == 0)
-      return nogo_move_result::illegal_take;
-    if (x < p_max.x && test.check_liberty(x + 1, y, opp) == 0)
-      return nogo_move_result::illegal_take;
-    if (y > p_min.y && test.check_liberty(x, y - 1, opp) == 0)
-      return nogo_move_result::illegal_take;
-    if (y < p_max.y && test.check_liberty(x, y + 1, opp) == 0)
-      return nogo_move_result::illegal_take;
-    stone[x][y] = who;  // is legal move!
-    attr.who_take_turns = static_cast<piece_type>(opp);
-    return nogo_move_result::legal;
+    return play(x, y, who, nullptr);
   }
   reward place(const point& p, unsigned who = piece_type::unknown) {
     return place(p.x, p.y, who);
   }
 
+  /**
+   * the information needed to take back a move, which is small enough to be
+   * kept in a fixed-capacity stack by the searcher
+   */
+  struct undo {
+    int8_t move;     // -1 if the move was illegal
+    uint8_t merged;  // the number of merges below
+    std::array<std::pair<uint8_t, uint8_t>, 4> merges;  // (anchor, absorbed)
+  };
+
+  /**
+   * same as place, but also record how to take the move back
+   */
+  reward make_move(const point& p, undo& record,
+                   unsigned who = piece_type::unknown) {
+    return play(p.x, p.y, who, &record);
+  }
+
+  /**
+   * take back the move recorded by make_move, which must be the last move
+   */
+  void unmake_move(const undo& record) {
+    if (record.move == -1) return;
+    int i = record.move;
+    bitboard move = bit(i), near = adjacent[i];
+    unsigned who = 3u - attr.who_take_turns, opp = attr.who_take_turns;
+    int anchor = block_of[i];
+    stone[who] &= ~move;
+    stone[piece_type::empty] |= move;
+    for (bitboard n = near & stone[opp]; n; n &= n - 1)
+      block_liberty[block_of[lowest(n)]] |= move;
+    for (int k = record.merged - 1; k >= 0; k--)
+      split(record.merges[k].first, record.merges[k].second);
+    if (anchor != i) {  // only the final anchor had its liberties replaced
+      bitboard block = 0;
+      int k = anchor;
+      do {
+        block |= bit(k);
+        k = block_link[k];
+      } while (k != anchor);
+      block_liberty[anchor] = neighbors(block) & stone[piece_type::empty];
+    }
+    bitboard dirty = move | near;
+    for (bitboard n = near & (stone[who] | stone[opp]); n; n &= n - 1)
+      dirty |= block_liberty[block_of[lowest(n)]];
+    refresh(dirty);
+    update_keys(who, i);
+    attr.who_take_turns = static_cast<piece_type>(who);
+  }
+
   /**
    * calculate the liberty of the block of piece at [x][y]
    * return >= 0 if [x][y] is placed by who; otherwise return -1
    */
   int check_liberty(int x, int y, unsigned who) const {
-    grid test = stone;
-    if (test[x][y] != who) return -1;
-
-    int liberty = 0;
-    std::list<point> check;
-    for (check.emplace_back(x, y); check.size(); check.pop_front()) {
-      int x = check.front().x, y = check.front().y;
-      test[x][y] = piece_type::unknown;  // prevent recalculate
-
-      point p_min(0, 0), p_max(size_x - 1, size_y - 1);
-
-      cell near_l = x > p_min.x ? test[x - 1][y] : -1u;  // left
-      if (near_l == piece_type::empty)
-        liberty++;
-      else if (near_l == who)
-        check.emplace_back(x - 1, y);
-
-      cell near_r = x < p_max.x ? test[x + 1][y] : -1u;  // right
-      if (near_r == piece_type::empty)
-        liberty++;
-      else if (near_r == who)
-        check.emplace_back(x + 1, y);
-
-      cell near_d = y > p_min.y ? test[x][y - 1] : -1u;  // down
-      if (near_d == piece_type::empty)
-        liberty++;
-      else if (near_d == who)
-        check.emplace_back(x, y - 1);
-
-      cell near_u = y < p_max.y ? test[x][y + 1] : -1u;  // up
-      if (near_u == piece_type::empty)
-        liberty++;
-      else if (near_u == who)
-        check.emplace_back(x, y + 1);
-    }
-    return liberty;
+    int i = point(x, y).i;
+    if (who != piece_type::black && who != piece_type::white) return -1;
+    if (!(stone[who] & bit(i))) return -1;
+    return count(block_liberty[block_of[i]]);
   }
 
-  void transpose() {
-    for (int x = 0; x < size_x; x++) {
-      for (int y = x + 1; y < size_y; y++) {
-        std::swap(stone[x][y], stone[y][x]);
+  /**
+   * the positions where who can legally place a stone
+   * who == piece_type::unknown indicates the next side
+   */
+  bitboard legal_moves(unsigned who = piece_type::unknown) const {
+    return legal_set(who).mask();
+  }
+  const move_set& legal_set(unsigned who = piece_type::unknown) const {
+    if (who == -1u) who = attr.who_take_turns;
+    return playable[who - 1];
+  }
+
+  /**
+   * play uniformly random legal moves on a copy of the board until the side
+   * to move has none, and return the number of moves played
+   *
+   * the copy keeps only blocks and liberties up to date, and each side draws
+   * from its own candidate list, which drops a cell as soon as it is found
+   * illegal, since a cell never becomes legal again for the same side in
+   * NoGo: liberties are only ever taken away. rng() must give 32 random bits
+   *
+   * if played is given, the moves of the side to move are added to played[0]
+   * and those of the other side to played[1]
+   */
+  template <typename random>
+  int playout(random& rng, bitboard* played = nullptr) const {
+    basic_board sim(*this);
+    std::array<std::array<uint8_t, size_x * size_y>, 2> list;
+    std::array<unsigned, 2> num;
+    for (int k = 0; k < 2; k++) {
+      num[k] = playable[k].size();
+      std::copy(playable[k].begin(), playable[k].end(), list[k].begin());
+    }
+    unsigned who = attr.who_take_turns;
+    int plies = 0;
+    for (;; plies++, who = 3u - who) {
+      auto& cells = list[who - 1];
+      unsigned& n = num[who - 1];
+      int i = -1;
+      while (n) {
+        unsigned k = (uint64_t(uint32_t(rng())) * n) >> 32;
+        i = cells[k];
+        if ((sim.stone[piece_type::empty] & bit(i)) && sim.check_legal(i, who))
+          break;
+        cells[k] = cells[--n];
+        i = -1;
       }
+      if (i == -1) break;
+      sim.drop(i, who);
+      if (played) played[plies % 2] |= bit(i);
     }
+    return plies;
+  }
+
+  void transpose() {
+    remap([](int x, int y) { return point(y, x); });
+  }
+
+  /**
+   * transform the board by the given symmetry, see symmetric()
+   */
+  void transform(int s) {
+    remap([s](int x, int y) { return symmetric(point(x, y), s); });
   }
 
   void reflect_horizontal() {
-    for (int y = 0; y < size_y; y++) {
-      for (int x = 0; x < size_x / 2; x++) {
-        std::swap(stone[x][y], stone[size_x - 1 - x][y]);
-      }
-    }
+    remap([](int x, int y) { return point(size_x - 1 - x, y); });
   }
 
   void reflect_vertical() {
-    for (int x = 0; x < size_x; x++) {
-      for (int y = 0; y < size_y / 2; y++) {
-        std::swap(stone[x][y], stone[x][size_y - 1 - y]);
-      }
-    }
+    remap([](int x, int y) { return point(x, size_y - 1 - y); });
   }
 
   /**
@@ -275,7 +602,38 @@ class board {
   }
 
  public:
-  friend std::ostream& operator<<(std::ostream& out, const board& b) {
+  /**
+   * bitboard utilities, where bit (i) stands for the position (i)
+   */
+  static constexpr bitboard bit(int i) { return bitboard(1) << i; }
+  static constexpr bitboard full() { return geometry::full(); }
+  static constexpr bitboard edge_down() { return geometry::edge_down(); }
+  static constexpr bitboard edge_up() { return geometry::edge_up(); }
+  static int count(bitboard b) {
+    return __builtin_popcountll(uint64_t(b)) +
+           __builtin_popcountll(uint64_t(b >> 64));
+  }
+  static int lowest(bitboard b) {
+    return uint64_t(b) ? __builtin_ctzll(uint64_t(b))
+                       : 64 + __builtin_ctzll(uint64_t(b >> 64));
+  }
+  /**
+   * the cells that are orthogonally adjacent to any cell of b
+   */
+  static bitboard neighbors(bitboard b) { return geometry::neighbors(b); }
+  /**
+   * the cells of area that are connected to the seed
+   */
+  static bitboard flood(bitboard seed, bitboard area) {
+    for (bitboard last = 0; last != seed;) {
+      last = seed;
+      seed |= neighbors(seed) & area;
+    }
+    return seed;
+  }
+
+ public:
+  friend std::ostream& operator<<(std::ostream& out, const basic_board& b) {
     std::ios ff(nullptr);
     ff.copyfmt(out);  // make a copy of the original print format
 
@@ -305,7 +663,7 @@ class board {
     out.copyfmt(ff);  // restore print format
     return out;
   }
-  friend std::istream& operator>>(std::istream& in, board& b) {
+  friend std::istream& operator>>(std::istream& in, basic_board& b) {
     std::string token;
     for (int x = 0; x < size_x; x++) in >> token; /* skip X */
     for (int y = size_y - 1; y >= 0 && in >> token /* skip Y */;
@@ -338,23 +696,268 @@ class board {
   }
 
  protected:
-  static const grid& initial() {
-    static grid stone;
-    return stone;
-  }
-  static __attribute__((constructor)) void init_initial_scheme() {
-    grid& stone = const_cast<grid&>(initial());
-    stone[4][1] = piece_type::hollow;
-    stone[4][2] = piece_type::hollow;
-    stone[4][6] = piece_type::hollow;
-    stone[4][7] = piece_type::hollow;
-    stone[1][4] = piece_type::hollow;
-    stone[2][4] = piece_type::hollow;
-    stone[6][4] = piece_type::hollow;
-    stone[7][4] = piece_type::hollow;
+  typedef typename make_index_list<size_x * size_y>::type indices;
+  typedef std::array<bitboard, size_x * size_y> adjacency_table;
+  typedef std::array<std::array<std::array<uint64_t, 8>, size_x * size_y>, 3>
+      zobrist_table;  // the key of a stone as seen by each symmetry
+
+  static constexpr bitboard hollow_cells = geometry::hollow();
+  static constexpr layers initial = {
+      {full() & ~hollow_cells, bitboard(0), bitboard(0), hollow_cells}};
+  static constexpr adjacency_table adjacent = geometry::adjacency(indices());
+  static constexpr zobrist_table zobrist = {
+      {geometry::zobrist(piece_type::empty, indices()),
+       geometry::zobrist(piece_type::black, indices()),
+       geometry::zobrist(piece_type::white, indices())}};
+  static constexpr uint64_t zobrist_white = geometry::turn_key();
+
+  static const std::array<move_set, 2>& initial_playable() {
+    static const std::array<move_set, 2> playable = make_initial_playable();
+    return playable;
+  }
+  static std::array<move_set, 2> make_initial_playable() {
+    grid g = {};
+    for (int i = 0; i < size_x * size_y; i++)
+      if (hollow_cells & bit(i)) g[i / size_y][i % size_y] = piece_type::hollow;
+    return basic_board(g, {piece_type::black}).playable;
+  }
+  static uint64_t zobrist_turn(unsigned who) {
+    return who == piece_type::white ? zobrist_white : 0;
   }
 
  private:
-  grid stone;
+  cell at(unsigned i) const {
+    bitboard b = bit(i);
+    if (stone[piece_type::black] & b) return piece_type::black;
+    if (stone[piece_type::white] & b) return piece_type::white;
+    if (stone[piece_type::hollow] & b) return piece_type::hollow;
+    return piece_type::empty;
+  }
+  void set(unsigned i, cell who) {
+    bitboard b = bit(i);
+    for (bitboard& layer : stone) layer &= ~b;
+    if (who < stone.size()) stone[who] |= b;
+  }
+  template <typename transform>
+  void remap(transform f) {
+    layers next = {};
+    for (int i = 0; i < size_x * size_y; i++) {
+      point p(i);
+      bitboard b = bit(f(p.x, p.y).i);
+      for (size_t t = 0; t < stone.size(); t++)
+        if (stone[t] & bit(i)) next[t] |= b;
+    }
+    stone = next;
+    rebuild();
+  }
+
+  /**
+   * place a stone as described in place, and fill the record if given
+   */
+  reward play(int x, int y, unsigned who, undo* record) {
+    if (record) record->move = -1;
+    if (who == -1u) who = attr.who_take_turns;
+    if (who != attr.who_take_turns) return nogo_move_result::illegal_turn;
+    if (x == -1 && y == -1) return nogo_move_result::illegal_pass;
+    if (x < 0 || x >= size_x || y < 0 || y >= size_y)
+      return nogo_move_result::illegal_out_of_range;
+    int i = point(x, y).i;
+    bitboard move = bit(i);
+    if (hollow_cells & move)
+      return nogo_move_result::illegal_out_of_range;
+    if (!(stone[piece_type::empty] & move))
+      return nogo_move_result::illegal_not_empty;
+    unsigned opp = 3u - who;
+    bitboard near = adjacent[i];
+    bitboard near_own = near & stone[who], near_opp = near & stone[opp];
+    bitboard liberty = near & stone[piece_type::empty];
+    for (bitboard n = near_own; n; n &= n - 1)
+      liberty |= block_liberty[block_of[lowest(n)]];
+    liberty &= ~move;
+    if (!liberty) return nogo_move_result::illegal_suicide;
+    for (bitboard n = near_opp; n; n &= n - 1)
+      if (!(block_liberty[block_of[lowest(n)]] & ~move))
+        return nogo_move_result::illegal_take;
+    stone[piece_type::empty] &= ~move;  // is legal move!
+    stone[who] |= move;
+    for (bitboard n = near_opp; n; n &= n - 1)
+      block_liberty[block_of[lowest(n)]] &= ~move;
+    block_of[i] = i;
+    block_link[i] = i;
+    block_size[i] = 1;
+    if (record) record->merged = 0;
+    for (bitboard n = near_own; n; n &= n - 1) {
+      int a = block_of[i], b = block_of[lowest(n)];
+      if (a == b) continue;
+      if (block_size[a] < block_size[b]) std::swap(a, b);
+      merge(a, b);
+      if (record) record->merges[record->merged++] = std::make_pair(a, b);
+    }
+    if (record) record->move = i;
+    block_liberty[block_of[i]] = liberty;
+    bitboard dirty = move | near | liberty;
+    for (bitboard n = near_opp; n; n &= n - 1)
+      dirty |= block_liberty[block_of[lowest(n)]];
+    refresh(dirty);
+    update_keys(who, i);
+    attr.who_take_turns = static_cast<piece_type>(opp);
+    return nogo_move_result::legal;
+  }
+
+  /**
+   * place a stone of who at the legal position i, and keep only the blocks
+   * and their liberties up to date, for playouts
+   */
+  void drop(int i, unsigned who) {
+    bitboard move = bit(i), near = adjacent[i];
+    stone[piece_type::empty] &= ~move;
+    stone[who] |= move;
+    for (bitboard n = near & stone[3u - who]; n; n &= n - 1)
+      block_liberty[block_of[lowest(n)]] &= ~move;
+    bitboard liberty = near & stone[piece_type::empty];
+    block_of[i] = i;
+    block_link[i] = i;
+    block_size[i] = 1;
+    for (bitboard n = near & stone[who] & ~move; n; n &= n - 1) {
+      int a = block_of[i], b = block_of[lowest(n)];
+      if (a == b) continue;
+      liberty |= block_liberty[b];
+      if (block_size[a] < block_size[b]) std::swap(a, b);
+      merge(a, b);
+    }
+    block_liberty[block_of[i]] = liberty & ~move;
+  }
+
+  /**
+   * toggle a stone of who at position i, and the side to move, in the keys
+   */
+  void update_keys(unsigned who, int i) {
+    auto& stone_keys = zobrist[who][i];
+    for (int s = 0; s < 8; s++) keys[s] ^= stone_keys[s] ^ zobrist_white;
+  }
+
+  /**
+   * join the block anchored at b into the block anchored at a
+   * the stones of b are relabeled, and the two circular lists are spliced
+   */
+  void merge(int a, int b) {
+    int i = b;
+    do {
+      block_of[i] = a;
+      i = block_link[i];
+    } while (i != b);
+    std::swap(block_link[a], block_link[b]);
+    block_size[a] += block_size[b];
+  }
+
+  /**
+   * undo merge(a, b), since swapping the links again splits the lists
+   */
+  void split(int a, int b) {
+    std::swap(block_link[a], block_link[b]);
+    int i = b;
+    do {
+      block_of[i] = b;
+      i = block_link[i];
+    } while (i != b);
+    block_size[a] -= block_size[b];
+  }
+
+  /**
+   * check whether who can legally place a stone at the empty position i
+   *
+   * a move is illegal if it fills the last liberty of an opponent block, or
+   * if it has neither an empty neighbor nor a friendly block that still has
+   * another liberty
+   */
+  bool check_legal(int i, unsigned who) const {
+    bitboard move = bit(i), near = adjacent[i];
+    bool safe = near & stone[piece_type::empty];
+    for (bitboard n = near & stone[who]; n && !safe; n &= n - 1) {
+      bitboard liberty = block_liberty[block_of[lowest(n)]];
+      safe = liberty & (liberty - 1);
+    }
+    if (!safe) return false;
+    for (bitboard n = near & stone[3u - who]; n; n &= n - 1)
+      if (block_liberty[block_of[lowest(n)]] == move) return false;
+    return true;
+  }
+
+  /**
+   * check the legality of the given positions again for both sides
+   */
+  void refresh(bitboard dirty) {
+    for (unsigned who : {piece_type::black, piece_type::white}) {
+      move_set& moves = playable[who - 1];
+      for (bitboard d = dirty; d; d &= d - 1) {
+        int i = lowest(d);
+        if ((stone[piece_type::empty] & bit(i)) && check_legal(i, who))
+          moves.insert(i);
+        else
+          moves.erase(i);
+      }
+    }
+  }
+
+  /**
+   * recalculate all blocks and legal moves from the bitboards
+   */
+  void rebuild() {
+    keys.fill(zobrist_turn(attr.who_take_turns));
+    for (unsigned who : {piece_type::black, piece_type::white}) {
+      for (bitboard rest = stone[who]; rest;) {
+        int anchor = lowest(rest), last = anchor;
+        bitboard block = flood(bit(anchor), stone[who]);
+        for (bitboard b = block; b; b &= b - 1) {
+          int i = lowest(b);
+          block_of[i] = anchor;
+          block_link[last] = i;
+          last = i;
+        }
+        block_link[last] = anchor;
+        block_size[anchor] = count(block);
+        block_liberty[anchor] = neighbors(block) & stone[piece_type::empty];
+        for (bitboard b = block; b; b &= b - 1) {
+          auto& stone_keys = zobrist[who][lowest(b)];
+          for (int s = 0; s < 8; s++) keys[s] ^= stone_keys[s];
+        }
+        rest &= ~block;
+      }
+    }
+    refresh(full());
+  }
+
+ private:
+  layers stone;
   data attr;
+
+  std::array<uint8_t, size_x * size_y> block_of;
+  std::array<uint8_t, size_x * size_y> block_link;
+  std::array<uint8_t, size_x * size_y> block_size;
+  std::array<bitboard, size_x * size_y> block_liberty;
+  std::array<move_set, 2> playable;  // indexed by piece_type - 1
+  std::array<uint64_t, 8> keys;  // indexed by symmetry
 };
+
+template <unsigned width, unsigned height, typename hollow_pattern>
+constexpr typename basic_board<width, height, hollow_pattern>::bitboard
+    basic_board<width, height, hollow_pattern>::hollow_cells;
+template <unsigned width, unsigned height, typename hollow_pattern>
+constexpr typename basic_board<width, height, hollow_pattern>::layers
+    basic_board<width, height, hollow_pattern>::initial;
+template <unsigned width, unsigned height, typename hollow_pattern>
+constexpr typename basic_board<width, height, hollow_pattern>::adjacency_table
+    basic_board<width, height, hollow_pattern>::adjacent;
+template <unsigned width, unsigned height, typename hollow_pattern>
+constexpr typename basic_board<width, height, hollow_pattern>::zobrist_table
+    basic_board<width, height, hollow_pattern>::zobrist;
+template <unsigned width, unsigned height, typename hollow_pattern>
+constexpr uint64_t basic_board<width, height, hollow_pattern>::zobrist_white;
+
+/**
+ * the board of Hollow NoGo in use, which is 9x9 unless BOARD_SIZE is defined
+ */
+#ifndef BOARD_SIZE
+#define BOARD_SIZE 9
+#endif
+typedef basic_board<BOARD_SIZE, BOARD_SIZE, hollow_cross> board;
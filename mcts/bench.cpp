@@ -0,0 +1,51 @@
+/**
+ * bench.cpp: measure the simulations per second of the shared-tree search
+ * from the empty board, for 1, 2, 4, ... threads
+ *
+ * usage: ./mcts-bench [milliseconds for each run] [most threads]
+ */
+#include <omp.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+
+#include "mcts.h"
+
+int main(int argc, char** argv) {
+  int timeout = argc > 1 ? std::atoi(argv[1]) : 2000;
+  int most = argc > 2 ? std::atoi(argv[2]) : omp_get_max_threads();
+
+  NoGoState state{board()};
+  for (int threads = 1;; threads = std::min(threads * 2, most)) {
+    NodePool pool;
+    NodeId root = CreateRootNode(pool, state);
+    std::vector<Random> engines(threads);
+    for (int i = 0; i < threads; i++) engines[i].seed(i);
+
+    SearchOptions options;
+    options.simulation_count = std::numeric_limits<int>::max();
+    options.minmax = true;
+    options.timeout = timeout;
+    options.threads = threads;
+    options.virtual_loss = 1;
+
+    auto start = std::chrono::steady_clock::now();
+#pragma omp parallel for num_threads(threads)
+    for (int i = 0; i < threads; i++) {
+      MCTS<UCB1>(pool, root, state, engines[i], options);
+    }
+    double elapsed = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+    std::printf("threads %3d: %10.0f simulations/s, %zu nodes, %zu MB\n",
+                threads, pool.Visits(root) / elapsed, pool.Size(),
+                pool.Bytes() >> 20);
+    if (threads == most) break;
+  }
+
+  return 0;
+}
@@ -2,94 +2,91 @@
 
 #include <omp.h>
 
-// using ActionNodeList = std::vector<std::vector<std::shared_ptr<Node>>>;
-// using NodeList = std::vector<std::shared_ptr<Node>>;
-
-// std::shared_ptr<Node> selection(std::shared_ptr<Node>, bool,
-// ActionNodeList&); std::shared_ptr<Node> selector(std::shared_ptr<Node>, bool,
-// ActionNodeList&);
-std::shared_ptr<Node> selection(std::shared_ptr<Node>, bool);
-std::shared_ptr<Node> selector(std::shared_ptr<Node>, bool);
-std::shared_ptr<Node> expansion(std::shared_ptr<Node>);
-double rollout(std::shared_ptr<Node>);
-void backpropagation(std::shared_ptr<Node>, double, bool);
-
-MCTSNodePtr CreateRootNode(State& state) {
-  auto new_state = state.Clone();
-  auto root = std::make_shared<Node>(new_state);
-
-  return root;
-}
-
-int MCTS(MCTSNodePtr& root, int simulation_count = 100, bool minmax = false) {
-  // ActionNodeList action_nodes(board::size_x * board::size_y);
-
-  while (simulation_count--) {
-    auto leaf = expansion(selection(root, minmax));
-
-    backpropagation(leaf, rollout(leaf), minmax);
+#include "search.h"
+
+/* the search compiled for NoGo, see search.h */
+template int MCTS<UCB1>(NodePool&, NodeId, const NoGoState&, Random&,
+                        const SearchOptions&);
+template int MCTS<UCB1Tuned>(NodePool&, NodeId, const NoGoState&, Random&,
+                             const SearchOptions&);
+template int MCTS<RAVE>(NodePool&, NodeId, const NoGoState&, Random&,
+                        const SearchOptions&);
+template int MCTS<PUCT>(NodePool&, NodeId, const NoGoState&, Random&,
+                        const SearchOptions&);
+template SearchFunction<NoGoState> GetSearch<NoGoState>(const std::string&);
+
+/**
+ * add the value to the AMAF statistics of the kids whose actions are in the
+ * set, where the value is from the same view as the values of the kids
+ */
+void update_amaf(NodePool& pool, NodeId id, ActionSet played, double value) {
+  const Node& node = pool[id];
+  for (NodeId kid = node.kids; kid < node.kids + node.kid_count; ++kid) {
+    if (!(played >> pool[kid].action & 1)) continue;
+    atomic_add(pool[kid].amaf_value, value);
+    pool[kid].amaf_visits += 1;
   }
-
-  return root->GetBestAction();
 }
 
-std::shared_ptr<Node> selection(std::shared_ptr<Node> node, bool minmax) {
-  while (node->IsLeaf() == false) {
-    node = selector(node, minmax);
+/**
+ * mark the node as proven for the side to move at it, and pass the proof up
+ * to the root by minimax: a kid that loses makes its parent win, and a parent
+ * loses once all of its kids win; only the thread that proves a node passes
+ * its proof on, so each kid is counted once
+ */
+void prove(NodePool& pool, NodeId root, NodeId id, Node::Proof proof) {
+  for (;;) {
+    int8_t unknown = Node::kUnknown;
+    if (!pool[id].proof.compare_exchange_strong(unknown, proof)) return;
+    if (id == root) return;
+
+    id = pool[id].parent;
+    Node& parent = pool[id];
+    if (proof == Node::kLoss) {
+      proof = Node::kWin;
+    } else if (++parent.won_kids == parent.kid_count) {
+      proof = Node::kLoss;
+    } else {
+      return;
+    }
   }
-
-  return node;
 }
 
-std::shared_ptr<Node> expansion(std::shared_ptr<Node> node) {
-  auto possible_actions = node->state->GetPossibleActions();
-  std::random_shuffle(possible_actions.begin(), possible_actions.end());
-  node->kids.reserve(possible_actions.size());
-
-  /* expand all possible node */
-  for (size_t action = 0; action < possible_actions.size(); ++action) {
-    auto new_state = node->state->Clone();
-    new_state->ApplyAction(possible_actions[action]);
-
-    auto new_node = std::make_shared<Node>(new_state);
-    new_node->parent = std::weak_ptr<Node>(node);
-    // list.at(action).push_back(new_node);
+/**
+ * make the node look like a loss to the one who selects it, until the
+ * simulation through it is backed up, so that threads spread out in the tree
+ */
+void add_virtual_loss(NodePool& pool, NodeId id,
+                      const SearchOptions& options) {
+  if (options.virtual_loss == 0) return;
+  pool.Visits(id) += options.virtual_loss;
+  atomic_add(pool.Value(id),
+             options.minmax ? options.virtual_loss : -options.virtual_loss);
+}
 
-    node->kids.push_back(new_node);
+void atomic_add(std::atomic<double>& target, double value) {
+  double expected = target.load(std::memory_order_relaxed);
+  while (!target.compare_exchange_weak(expected, expected + value,
+                                       std::memory_order_relaxed)) {
   }
-
-  if (node->kids.empty()) return node;
-
-  return node->kids.front();
 }
 
-double rollout(std::shared_ptr<Node> node) {
-  double reward = 0.0;
-
-  auto s = node->state->Clone();
-  while (s->IsTerminated() == false) {
-    auto possible_actions = s->GetPossibleActions();
-    if (possible_actions.size() == 0) break;
-    std::random_shuffle(possible_actions.begin(), possible_actions.end());
-
-    s->ApplyAction(possible_actions.front());
+/**
+ * whether the most visited kid of the root can no longer be overtaken by
+ * another kid in the given number of remaining simulations
+ */
+bool decided(NodePool& pool, NodeId root, double remaining) {
+  const Node& node = pool[root];
+  uint32_t first = 0, second = 0;
+  for (NodeId kid = node.kids; kid < node.kids + node.kid_count; ++kid) {
+    uint32_t visits = pool.Visits(kid);
+    if (visits > first) {
+      second = first;
+      first = visits;
+    } else if (visits > second) {
+      second = visits;
+    }
   }
 
-  reward += s->GetReward();
-
-  return reward;
+  return first - second > remaining;
 }
-
-void backpropagation(std::shared_ptr<Node> node, double value,
-                     bool minmax = false) {
-  node->value = value;
-  node->visits += 1;
-
-  while (node->parent.lock() != nullptr) {
-    node = node->parent.lock();
-    if (minmax) value = -value;
-
-    node->value += value;
-    node->visits += 1;
-  }
-}
\ No newline at end of file
@@ -1,52 +1,157 @@
 #pragma once
+#include <atomic>
 #include <cassert>
 #include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <random>
 #include <vector>
 
 #include "../action.h"
 #include "../board.h"
 
 class Node;
+class NodePool;
 
-using MCTSNodePtr = std::shared_ptr<Node>;
+/**
+ * index of a node in its NodePool, which is half the size of a pointer and
+ * needs no reference counting
+ */
+using NodeId = uint32_t;
+constexpr NodeId kNullNode = ~NodeId(0);
 
+/**
+ * read-only view of the actions kept inside a state, so that querying the
+ * possible actions never allocates
+ */
+class ActionList {
+ public:
+  ActionList() : first_(nullptr), last_(nullptr) {}
+  ActionList(const uint8_t* first, const uint8_t* last)
+      : first_(first), last_(last) {}
+
+  size_t size() const { return last_ - first_; }
+  bool empty() const { return first_ == last_; }
+  int operator[](size_t i) const { return first_[i]; }
+  const uint8_t* begin() const { return first_; }
+  const uint8_t* end() const { return last_; }
+
+ private:
+  const uint8_t* first_;
+  const uint8_t* last_;
+};
+
+/**
+ * a set of actions where bit a stands for the action a, which covers every
+ * action a node can hold
+ */
+using ActionSet = unsigned __int128;
+
+/**
+ * xorshift64* generator, which is small enough for each thread to own one and
+ * fast enough to pick every move of a playout
+ */
+class Random {
+ public:
+  using result_type = uint32_t;
+  explicit Random(uint64_t seed = 1) { this->seed(seed); }
+
+  void seed(uint64_t seed) {
+    uint64_t z = seed + 0x9e3779b97f4a7c15ull;  // splitmix64, never zero
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    state_ = (z ^ (z >> 31)) | 1;
+  }
+  result_type operator()() {
+    state_ ^= state_ >> 12;
+    state_ ^= state_ << 25;
+    state_ ^= state_ >> 27;
+    return (state_ * 0x2545f4914f6cdd1dull) >> 32;
+  }
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return ~result_type(0); }
+
+ private:
+  uint64_t state_;
+};
+
+/**
+ * the base of a game state, where Game is the state deriving from it, so that
+ * the search is compiled for each game and calls it without virtual dispatch
+ *
+ * a game is a value type, which the search copies once and then updates in
+ * place as it walks the tree; it provides
+ *
+ *   ActionList GetPossibleActions();  // of the side to move
+ *   void ApplyAction(int);
+ *   void UndoAction();                // the last action applied
+ *
+ * and may hide the defaults below, e.g., with a faster Rollout, or with the
+ * hashes of its positions for the transposition table
+ */
+template <class Game>
 class State {
  public:
   State() : action_(-1), reward_(0), terminated_(false) {}
   State(double init_reward)
       : action_(-1), reward_(init_reward), terminated_(false) {}
-  virtual ~State() {}
-  virtual std::shared_ptr<State> Clone() {
-    return std::shared_ptr<State>(this);
-  };
 
-  virtual std::vector<int> GetPossibleActions() { return std::vector<int>(); }
-  virtual void ApplyAction(const int action) {}
+  /**
+   * play random moves to the end of the game and take them back, and return
+   * the reward for the side to move; if played is given, add the moves of
+   * the side to move to played[0] and those of the other side to played[1]
+   */
+  double Rollout(Random& engine, ActionSet* played) {
+    /* play out on the state itself, and undo the moves afterwards */
+    Game& game = static_cast<Game&>(*this);
+    double sign = -GetReward();  // as seen from a fresh state at the leaf
+    int depth = 0;
+    while (IsTerminated() == false) {
+      auto possible_actions = game.GetPossibleActions();
+      if (possible_actions.size() == 0) break;
+
+      int action = possible_actions[engine() % possible_actions.size()];
+      if (played) played[depth % 2] |= ActionSet(1) << action;
+      game.ApplyAction(action);
+      depth++;
+    }
+
+    double reward = sign * GetReward();
+    while (depth--) game.UndoAction();
+
+    return reward;
+  }
   int GetAction() const { return action_; }
   double GetReward() const { return reward_; }
   bool IsTerminated() const { return terminated_; }
-
-  virtual bool operator==(const State& s) const {
-    return action_ == s.GetAction();
-  }
+  uint64_t GetHash() const { return action_; }
+  uint64_t GetHashAfter(int) const { return 0; }
 
  protected:
+  ~State() = default;  // a state is never deleted through its base
+
   int action_;
   double reward_;
   bool terminated_;
 };
 
-class NoGoState : public State {
+/**
+ * NoGo state that applies and undoes actions in place, the undo records are
+ * kept in a fixed-capacity stack so that walking the game never allocates
+ */
+class NoGoState : public State<NoGoState> {
  public:
-  NoGoState(board b) : State(-1.0), board_(b) {}
-  NoGoState(const NoGoState& s) : State(-1.0), board_(s.board_) {}
-  NoGoState(NoGoState&& s) : State(-1.0), board_(std::move(s.board_)) {}
+  NoGoState(board b) : State(-1.0), board_(b), depth_(0), origin_(-1) {}
+  NoGoState(const NoGoState& s)
+      : State(-1.0), board_(s.board_), depth_(0), origin_(-1) {}
+  NoGoState(NoGoState&& s)
+      : State(-1.0), board_(std::move(s.board_)), depth_(0), origin_(-1) {}
   NoGoState& operator=(const NoGoState& s) {
     if (this != &s) {
       board_ = s.board_;
       reward_ = -1.0;
+      depth_ = 0;
     }
 
     return *this;
@@ -55,43 +160,227 @@ class NoGoState : public State {
     if (this != &s) {
       board_ = std::move(s.board_);
       reward_ = -1.0;
+      depth_ = 0;
     }
 
     return *this;
   }
 
-  virtual bool operator==(const NoGoState& s) const {
-    return board_ == (s).board_;
-  }
-
-  std::shared_ptr<State> Clone() {
-    return std::make_shared<NoGoState>(this->board_);
+  bool operator==(const NoGoState& s) const { return board_ == s.board_; }
+  uint64_t GetHash() const { return board_.hash(); }
+  uint64_t GetHashAfter(int action) const {
+    return board_.hash_after(action);
   }
-  virtual ~NoGoState() {}
 
-  virtual std::vector<int> GetPossibleActions() override;
-  virtual void ApplyAction(const int) override;
+  ActionList GetPossibleActions();
+  void ApplyAction(const int);
+  void UndoAction();
+  double Rollout(Random&, ActionSet*);
 
  private:
   board board_;
+  std::array<board::undo, board::size_x * board::size_y> history_;
+  size_t depth_;
+  int origin_;  // the action before the first undoable ply
 };
 
+/**
+ * a node keeps only the action that leads to it and its links, the position
+ * is rebuilt by replaying the actions from the root when the search descends
+ * into it, and its value and visits are kept by the pool beside the node
+ *
+ * the statistics are atomic so that several threads can search one tree, and
+ * the kids of a node are created by the one thread that wins its expansion
+ */
 class Node {
  public:
+  enum Expansion : uint8_t { kLeaf, kExpanding, kExpanded };
+  // a proven result of the game for the side to move at the node
+  enum Proof : int8_t { kLoss = -1, kUnknown = 0, kWin = 1 };
+
   Node();
-  Node(std::shared_ptr<State>);
-  int GetBestAction() const;
+  Node(const Node&);
+  Node& operator=(const Node&);
   bool IsLeaf() const;
-  std::shared_ptr<Node> FindChild(State&);
 
-  uint32_t visits;
-  double value;
+  // all-moves-as-first statistics of the action, in the same view as value
+  std::atomic<double> amaf_value;
+  std::atomic<uint32_t> amaf_visits;
+
+  NodeId parent;
+  NodeId kids;  // the first of kid_count contiguous nodes
+  uint8_t kid_count;
+  int8_t action;
+  std::atomic<uint8_t> expansion;
+  std::atomic<int8_t> proof;
+  std::atomic<uint8_t> won_kids;  // proven wins for the kids, losses here
+};
+
+/**
+ * arena of nodes addressed by NodeId, where the kids of a node are allocated
+ * as one contiguous block
+ *
+ * the values and visits of the nodes are kept in arrays of their own, so the
+ * statistics of the kids of a node are contiguous and can be scanned with
+ * vector instructions by the selection
+ *
+ * the nodes are kept in fixed-size chunks that never move, so references to
+ * nodes stay valid while the pool grows, and Clear() drops a whole tree in
+ * O(1) while keeping the chunks for the next search; Allocate() may be called
+ * by several threads at once
+ */
+class NodePool {
+ public:
+  NodePool() : chunk_count_(0), size_(0) {}
+  NodePool(NodePool&&);
+  NodePool& operator=(NodePool&&);
+
+  Node& operator[](NodeId id) {
+    return chunks_[id >> kChunkBits]->node[id & kChunkMask];
+  }
+  const Node& operator[](NodeId id) const {
+    return chunks_[id >> kChunkBits]->node[id & kChunkMask];
+  }
+  std::atomic<double>& Value(NodeId id) {
+    return chunks_[id >> kChunkBits]->value[id & kChunkMask];
+  }
+  const std::atomic<double>& Value(NodeId id) const {
+    return chunks_[id >> kChunkBits]->value[id & kChunkMask];
+  }
+  std::atomic<uint32_t>& Visits(NodeId id) {
+    return chunks_[id >> kChunkBits]->visits[id & kChunkMask];
+  }
+  const std::atomic<uint32_t>& Visits(NodeId id) const {
+    return chunks_[id >> kChunkBits]->visits[id & kChunkMask];
+  }
+  /**
+   * the values and visits from the given node on, as plain arrays for vector
+   * loads, which may see a concurrent update of one lane but never a torn one
+   */
+  const double* Values(NodeId id) const {
+    return reinterpret_cast<const double*>(&Value(id));
+  }
+  const uint32_t* VisitCounts(NodeId id) const {
+    return reinterpret_cast<const uint32_t*>(&Visits(id));
+  }
+  NodeId Allocate(size_t);
+  NodeId CopySubtree(const NodePool&, NodeId, size_t limit = 0);
+  void Clear();
+  size_t Size() const { return size_; }
+  // the most nodes that fit, short of a chunk that a block may skip over
+  static constexpr size_t Capacity() {
+    return size_t(kMaxChunks - 1) * kChunkSize;
+  }
+  // the memory held, which a Clear() keeps for reuse
+  size_t Bytes() const { return size_t(chunk_count_) * sizeof(Chunk); }
+  static constexpr size_t NodeBytes() { return sizeof(Chunk) / kChunkSize; }
+
+  int GetBestAction(NodeId) const;
+  NodeId FindChild(NodeId, int) const;
+
+ private:
+  static constexpr unsigned kChunkBits = 16;
+  static constexpr NodeId kChunkSize = NodeId(1) << kChunkBits;
+  static constexpr NodeId kChunkMask = kChunkSize - 1;
+  static constexpr NodeId kMaxChunks = 4096;
+
+  struct Chunk {
+    std::atomic<double> value[kChunkSize];
+    std::atomic<uint32_t> visits[kChunkSize];
+    Node node[kChunkSize];
+  };
+  static_assert(sizeof(std::atomic<double>) == sizeof(double) &&
+                    sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+                "the statistics must be readable as plain arrays");
+  void Reset(NodeId);
 
-  std::weak_ptr<Node> parent;
-  std::vector<std::shared_ptr<Node>> kids;
-  std::shared_ptr<State> state;
+  // a fixed table of chunks, so that growing never moves what others read
+  std::unique_ptr<std::unique_ptr<Chunk>[]> chunks_;
+  NodeId chunk_count_;
+  NodeId size_;  // the next free node
+  std::mutex mutex_;
 };
 
-MCTSNodePtr CreateRootNode(State&);
+/**
+ * statistics of positions shared by all the paths that reach them, kept in a
+ * fixed table of two-entry buckets indexed by the position hash
+ *
+ * the entries are read and updated without locks, where a race may rarely mix
+ * the statistics of two positions, which only adds noise to the search; when
+ * a bucket is full, the entry with fewer visits is replaced
+ */
+class TranspositionTable {
+ public:
+  struct Entry {
+    std::atomic<uint64_t> key;  // the tag of the key, see Tag, or 0 if empty
+    std::atomic<double> value;
+    std::atomic<uint32_t> visits;
+  };
+
+  TranspositionTable(size_t);
+  const Entry* Find(uint64_t) const;
+  void Update(uint64_t, double);
+  void Clear();
+  size_t Size() const { return (mask_ + 1) * 2; }
+
+ private:
+  /**
+   * the key as stored, with its lowest bit set so that no key reads as an
+   * empty entry, e.g., the empty board with black to move hashes to 0; the
+   * bit is part of the bucket index, so no two keys of a bucket are merged
+   */
+  static uint64_t Tag(uint64_t key) { return key | 1; }
+
+  std::unique_ptr<Entry[]> entries_;
+  size_t mask_;  // of the bucket index, as there are 2^k buckets
+};
+
+/**
+ * the parameters of a search, see MCTS()
+ */
+struct SearchOptions {
+  int simulation_count = 100;  // for each thread
+  bool minmax = false;
+  int timeout = 0;       // in milliseconds, 0 for no limit
+  int threads = 1;       // the number of threads searching the same tree
+  int virtual_loss = 0;  // for each running simulation through a node
+  int playouts = 1;      // run at once from each leaf, see leaf_playouts
+  double rave = 1000;    // the equivalence parameter k of RAVE
+  double rave_bias = 0;  // if > 0, use the minimum-MSE schedule with this b
+  double c_puct = 1.0;   // the exploration constant of PUCT
+  TranspositionTable* table = nullptr;  // shared statistics, if any
+  const std::atomic<bool>* stop = nullptr;  // ends the search once set
+  size_t node_limit = 0;  // of the pool, past which no node is expanded
+};
+
+template <class Game>
+NodeId CreateRootNode(NodePool& pool, const Game& state) {
+  NodeId root = pool.Allocate(1);
+  pool[root].action = state.GetAction();
+
+  return root;
+}
+
+void atomic_add(std::atomic<double>&, double);
+
+/**
+ * the selection policies, see selector/
+ */
+struct UCB1;
+struct UCB1Tuned;
+struct RAVE;
+struct PUCT;
+
+/**
+ * the search of the given game with the given selection policy, which is
+ * defined in search.h and compiled for NoGoState in mcts.cpp, so that other
+ * games include search.h instead
+ */
+template <class Selector, class Game>
+int MCTS(NodePool&, NodeId, const Game&, Random&, const SearchOptions&);
 
-int MCTS(MCTSNodePtr&, int, bool);
+template <class Game>
+using SearchFunction = int (*)(NodePool&, NodeId, const Game&, Random&,
+                               const SearchOptions&);
+template <class Game>
+SearchFunction<Game> GetSearch(const std::string&);
@@ -1,34 +1,164 @@
 #include <algorithm>
+#include <queue>
 
 #include "mcts.h"
 
-Node::Node() = default;
-Node::Node(std::shared_ptr<State> state) : visits(0), value(0), state(state) {}
+Node::Node()
+    : amaf_value(0),
+      amaf_visits(0),
+      parent(kNullNode),
+      kids(kNullNode),
+      kid_count(0),
+      action(-1),
+      expansion(kLeaf),
+      proof(kUnknown),
+      won_kids(0) {}
+Node::Node(const Node& node)
+    : amaf_value(node.amaf_value.load()),
+      amaf_visits(node.amaf_visits.load()),
+      parent(node.parent),
+      kids(node.kids),
+      kid_count(node.kid_count),
+      action(node.action),
+      expansion(node.expansion.load()),
+      proof(node.proof.load()),
+      won_kids(node.won_kids.load()) {}
 
-int Node::GetBestAction() const {
+Node& Node::operator=(const Node& node) {
+  amaf_value = node.amaf_value.load();
+  amaf_visits = node.amaf_visits.load();
+  parent = node.parent;
+  kids = node.kids;
+  kid_count = node.kid_count;
+  action = node.action;
+  expansion = node.expansion.load();
+  proof = node.proof.load();
+  won_kids = node.won_kids.load();
+  return *this;
+}
+
+bool Node::IsLeaf() const {
+  return expansion.load(std::memory_order_acquire) != kExpanded;
+}
+
+NodePool::NodePool(NodePool&& pool)
+    : chunks_(std::move(pool.chunks_)),
+      chunk_count_(pool.chunk_count_),
+      size_(pool.size_) {
+  pool.chunk_count_ = 0;
+  pool.size_ = 0;
+}
+
+NodePool& NodePool::operator=(NodePool&& pool) {
+  std::swap(chunks_, pool.chunks_);
+  std::swap(chunk_count_, pool.chunk_count_);
+  std::swap(size_, pool.size_);
+  return *this;
+}
+
+NodeId NodePool::Allocate(size_t count) {
+  assert(count <= kChunkSize);
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!chunks_) chunks_.reset(new std::unique_ptr<Chunk>[kMaxChunks]);
+
+  NodeId first = size_;
+  if ((first & kChunkMask) + count > kChunkSize) {
+    first = (first | kChunkMask) + 1;  // a block never spans two chunks
+  }
+  for (NodeId id = size_; id < first; ++id) Reset(id);
+  NodeId last = first + count;
+  while (chunk_count_ * kChunkSize < last) {
+    assert(chunk_count_ < kMaxChunks);
+    chunks_[chunk_count_++].reset(new Chunk);
+  }
+  for (NodeId id = first; id < last; ++id) Reset(id);
+
+  size_ = last;
+  return first;
+}
+
+void NodePool::Reset(NodeId id) {
+  (*this)[id] = Node();
+  Value(id).store(0, std::memory_order_relaxed);
+  Visits(id).store(0, std::memory_order_relaxed);
+}
+
+/**
+ * copy the subtree under the given node of another pool, and return its root
+ * in this pool; the kids of the most visited nodes are copied first, and if
+ * a limit is given, the nodes whose kids no longer fit under it are kept as
+ * leaves with their own statistics, so that only the least visited subtrees
+ * are dropped
+ */
+NodeId NodePool::CopySubtree(const NodePool& from, NodeId id, size_t limit) {
+  assert(this != &from);
+  NodeId root = Allocate(1);
+  (*this)[root] = from[id];
+  (*this)[root].parent = kNullNode;
+  Value(root) = from.Value(id).load();
+  Visits(root) = from.Visits(id).load();
+
+  std::priority_queue<std::pair<uint32_t, NodeId>> open;  // (visits, node)
+  if (!(*this)[root].IsLeaf()) open.emplace(Visits(root), root);
+  while (!open.empty()) {
+    NodeId next = open.top().second;
+    open.pop();
+    auto& node = (*this)[next];
+    if (limit && size_ + node.kid_count > limit) {
+      node.kids = kNullNode;
+      node.kid_count = 0;
+      node.won_kids = 0;
+      node.expansion = Node::kLeaf;
+      continue;
+    }
+
+    NodeId kids = Allocate(node.kid_count);
+    for (NodeId kid = 0; kid < node.kid_count; ++kid) {
+      (*this)[kids + kid] = from[node.kids + kid];
+      (*this)[kids + kid].parent = next;
+      Value(kids + kid) = from.Value(node.kids + kid).load();
+      Visits(kids + kid) = from.Visits(node.kids + kid).load();
+      if (!(*this)[kids + kid].IsLeaf())
+        open.emplace(Visits(kids + kid), kids + kid);
+    }
+    node.kids = kids;
+  }
+
+  return root;
+}
+
+void NodePool::Clear() { size_ = 0; }
+
+/**
+ * the action of a kid proven to lose, which wins for this node, or else the
+ * most visited kid among those not proven to win, if there are any
+ */
+int NodePool::GetBestAction(NodeId id) const {
+  const Node& node = (*this)[id];
   uint32_t best_visits = 0;
   int best_action = -1;
+  bool best_won = true;
 
-  for (auto& kid : kids) {
-    if (kid->visits > best_visits) {
-      best_visits = kid->visits;
-      best_action = kid->state->GetAction();
+  for (NodeId kid = node.kids; kid < node.kids + node.kid_count; ++kid) {
+    int8_t proof = (*this)[kid].proof;
+    if (proof == Node::kLoss) return (*this)[kid].action;
+    bool won = proof == Node::kWin;
+    uint32_t visits = Visits(kid);
+    if ((best_won && !won) || (won == best_won && visits > best_visits)) {
+      best_visits = visits;
+      best_action = (*this)[kid].action;
+      best_won = won;
     }
   }
 
   return best_action;
 }
 
-bool Node::IsLeaf() const { return kids.empty(); }
-
-MCTSNodePtr Node::FindChild(State& state) {
-  MCTSNodePtr selected_node;
-  for (auto node : kids) {
-    if (*(node->state) == state) {
-      selected_node = node;
-      break;
-    }
+NodeId NodePool::FindChild(NodeId id, int action) const {
+  const Node& node = (*this)[id];
+  for (NodeId kid = node.kids; kid < node.kids + node.kid_count; ++kid) {
+    if ((*this)[kid].action == action) return kid;
   }
 
-  return selected_node;
+  return kNullNode;
 }
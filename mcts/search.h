@@ -0,0 +1,205 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#include "mcts.h"
+#include "selector/mc_rave.h"
+#include "selector/puct.h"
+#include "selector/ucb1.h"
+#include "selector/ucb1_tuned.h"
+
+/**
+ * the search as templates over the game and the selection policy, so that
+ * every call into the game is resolved at compile time; see mcts.cpp for the
+ * parts that do not depend on the game
+ */
+
+template <class Selector, class Game>
+NodeId selection(NodePool&, NodeId, Game&, const SearchOptions&);
+template <class Game>
+NodeId expansion(NodePool&, NodeId, Game&, Random&, const SearchOptions&);
+template <class Game>
+void backpropagation(NodePool&, NodeId, NodeId, double, Game&, ActionSet*,
+                     const SearchOptions&);
+void update_amaf(NodePool&, NodeId, ActionSet, double);
+void add_virtual_loss(NodePool&, NodeId, const SearchOptions&);
+void prove(NodePool&, NodeId, NodeId, Node::Proof);
+bool decided(NodePool&, NodeId, double);
+
+/**
+ * leaf parallelism: run the playouts of a leaf at once, each on its own copy
+ * of the state with its own engine seeded from the given one, and return the
+ * sum of their rewards; the moves of all playouts are merged into played
+ *
+ * the playouts take the idle threads of OpenMP, which are all but one when
+ * the search runs on a single thread, and none inside a parallel search,
+ * where the playouts run one after another on the calling thread
+ */
+template <class Game>
+double leaf_playouts(const Game& state, Random& engine, int count,
+                     ActionSet* played) {
+  uint64_t seed = uint64_t(engine()) << 32 | engine();
+  double value = 0;
+#pragma omp parallel for reduction(+ : value) schedule(static)
+  for (int playout = 0; playout < count; ++playout) {
+    Game copy = state;
+    Random local(seed + playout);
+    ActionSet moves[2] = {};
+    value += copy.Rollout(local, played ? moves : nullptr);
+    if (played) {
+#pragma omp critical(leaf_playouts)
+      {
+        played[0] |= moves[0];
+        played[1] |= moves[1];
+      }
+    }
+  }
+
+  return value;
+}
+
+/**
+ * search the tree under root, which may be shared with other threads that
+ * are calling this at the same time, each with its own random engine
+ *
+ * Selector picks the kid to descend into, and is compiled into the loop
+ */
+template <class Selector, class Game>
+int MCTS(NodePool& pool, NodeId root, const Game& state, Random& engine,
+         const SearchOptions& options) {
+  auto start = std::chrono::steady_clock::now();
+
+  /* the positions of the nodes are replayed on a scratch copy of the root */
+  Game scratch = state;
+  for (int count = 0; count < options.simulation_count; ++count) {
+    if (pool[root].proof != Node::kUnknown) break;
+    if (options.stop && options.stop->load(std::memory_order_relaxed)) break;
+    if (count % 64 == 0 && count > 0) {
+      double elapsed = std::chrono::duration<double, std::milli>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+      double remaining = options.simulation_count - count;
+      if (options.timeout > 0) {
+        if (elapsed >= options.timeout) break;
+        remaining = std::min(remaining,
+                             count * (options.timeout - elapsed) / elapsed);
+      }
+      if (decided(pool, root, remaining * options.threads)) break;
+    }
+
+    auto leaf =
+        expansion(pool, selection<Selector>(pool, root, scratch, options),
+                  scratch, engine, options);
+    if (options.minmax && scratch.GetPossibleActions().empty()) {
+      prove(pool, root, leaf, Node::kLoss);  // the side to move has lost
+    }
+
+    double value = 0;
+    ActionSet played[2] = {};
+    if (options.playouts == 1) {
+      value = scratch.Rollout(engine, Selector::kAmaf ? played : nullptr);
+    } else {
+      value = leaf_playouts(scratch, engine, options.playouts,
+                            Selector::kAmaf ? played : nullptr);
+    }
+    backpropagation(pool, root, leaf, value / options.playouts, scratch,
+                    Selector::kAmaf ? played : nullptr, options);
+  }
+
+  return pool.GetBestAction(root);
+}
+
+/**
+ * the search with the named selection policy, which is one of ucb1,
+ * ucb1-tuned, rave and puct
+ */
+template <class Game>
+SearchFunction<Game> GetSearch(const std::string& policy) {
+  if (policy == "ucb1") return MCTS<UCB1, Game>;
+  if (policy == "ucb1-tuned") return MCTS<UCB1Tuned, Game>;
+  if (policy == "rave") return MCTS<RAVE, Game>;
+  if (policy == "puct") return MCTS<PUCT, Game>;
+  throw std::invalid_argument("invalid policy: " + policy);
+}
+
+template <class Selector, class Game>
+NodeId selection(NodePool& pool, NodeId node, Game& state,
+                 const SearchOptions& options) {
+  while (pool[node].IsLeaf() == false) {
+    node = Selector::Select(pool, node, state, options);
+    add_virtual_loss(pool, node, options);
+    state.ApplyAction(pool[node].action);
+  }
+
+  return node;
+}
+
+template <class Game>
+NodeId expansion(NodePool& pool, NodeId id, Game& state, Random& engine,
+                 const SearchOptions& options) {
+  auto& node = pool[id];
+  auto possible_actions = state.GetPossibleActions();
+  if (possible_actions.empty()) return id;
+
+  /* once the pool is full, the leaves are only played out from */
+  size_t limit = options.node_limit ? options.node_limit : pool.Capacity();
+  if (pool.Size() + possible_actions.size() > limit) return id;
+
+  /* only one thread expands a node, the others play out from the node */
+  uint8_t leaf = Node::kLeaf;
+  if (!node.expansion.compare_exchange_strong(leaf, Node::kExpanding)) {
+    return id;
+  }
+
+  /* expand all possible node as one block, without their positions */
+  NodeId kids = pool.Allocate(possible_actions.size());
+  Node* first = &pool[kids];
+  for (size_t action = 0; action < possible_actions.size(); ++action) {
+    first[action].action = possible_actions[action];
+    first[action].parent = id;
+  }
+  std::shuffle(first, first + possible_actions.size(), engine);
+  node.kids = kids;
+  node.kid_count = possible_actions.size();
+  node.expansion.store(Node::kExpanded, std::memory_order_release);
+
+  add_virtual_loss(pool, kids, options);
+  state.ApplyAction(first->action);
+  return kids;
+}
+
+/**
+ * back up the value from the leaf to the root, and take the moves back on
+ * the state, which also gives the positions to update in the table
+ *
+ * if given, played holds the moves of the playouts by the side to move at the
+ * leaf and by the other side, and the moves of the path are added as it is
+ * walked up, so that every kid whose action was played later by the side
+ * choosing it gets the value as an all-moves-as-first sample
+ */
+template <class Game>
+void backpropagation(NodePool& pool, NodeId root, NodeId node, double value,
+                     Game& state, ActionSet* played,
+                     const SearchOptions& options) {
+  double loss = options.minmax ? options.virtual_loss : -options.virtual_loss;
+  for (;; node = pool[node].parent) {
+    if (options.table) options.table->Update(state.GetHash(), value);
+    if (node == root) {  // the only node without a virtual loss
+      atomic_add(pool.Value(node), value);
+      pool.Visits(node) += 1;
+      break;
+    }
+    atomic_add(pool.Value(node), value - loss);
+    pool.Visits(node) += 1 - options.virtual_loss;
+    state.UndoAction();
+
+    if (options.minmax) value = -value;
+    if (played) {
+      std::swap(played[0], played[1]);
+      played[0] |= ActionSet(1) << pool[node].action;
+      update_amaf(pool, pool[node].parent, played[0],
+                  options.minmax ? -value : value);
+    }
+  }
+}
@@ -0,0 +1,164 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/**
+ * log(n) and 1 / sqrt(n) for the small visit counts met in most of the tree,
+ * computed once
+ */
+class VisitTables {
+ public:
+  static constexpr uint32_t kSize = 4096;
+
+  static double Log(uint32_t n) {
+    return n < kSize ? Get().log_[n] : std::log(double(n));
+  }
+  static double InverseSqrt(uint32_t n) {
+    return n < kSize ? Get().inverse_sqrt_[n] : 1 / std::sqrt(double(n));
+  }
+
+ private:
+  VisitTables() {
+    log_[0] = -std::numeric_limits<double>::infinity();
+    inverse_sqrt_[0] = 1;  // as for one visit, like max(visits, 1)
+    for (uint32_t n = 1; n < kSize; ++n) {
+      log_[n] = std::log(double(n));
+      inverse_sqrt_[n] = 1 / std::sqrt(double(n));
+    }
+  }
+  static const VisitTables& Get() {
+    static const VisitTables tables;
+    return tables;
+  }
+
+  double log_[kSize];
+  double inverse_sqrt_[kSize];
+};
+
+/**
+ * the scalar UCB1 argmax over kids [kid, count), given the best score and
+ * kid found before kid, see ucb_argmax
+ */
+inline size_t ucb_argmax_from(const double* value, const uint32_t* visits,
+                              size_t kid, size_t count, double revert,
+                              double explore, double best_value,
+                              size_t best_child) {
+  for (; kid < count; ++kid) {
+    if (visits[kid] == 0) return kid;
+    double v = revert * value[kid] / visits[kid] +
+               explore * VisitTables::InverseSqrt(visits[kid]);
+    if (v > best_value) {
+      best_value = v;
+      best_child = kid;
+    }
+  }
+
+  return best_child;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/**
+ * the AVX2 version of ucb_argmax, compiled for AVX2 whatever the flags of
+ * the build are, and called only on the processors that support it; the
+ * lanes compute a mean and an exploration term with one division and one
+ * square root as (revert * value + explore * sqrt(visits)) / visits
+ */
+__attribute__((target("avx2"))) inline size_t ucb_argmax_avx2(
+    const double* value, const uint32_t* visits, size_t count, double revert,
+    double explore) {
+  size_t kid = 0;
+  double best_value = -std::numeric_limits<double>::infinity();
+  size_t best_child = 0;
+
+  const __m256d revert4 = _mm256_set1_pd(revert);
+  const __m256d explore4 = _mm256_set1_pd(explore);
+  __m256d best4 = _mm256_set1_pd(best_value);
+  __m256d index4 = _mm256_set_pd(3, 2, 1, 0);
+  __m256d best_index4 = _mm256_setzero_pd();
+  for (; kid + 4 <= count; kid += 4) {
+    __m128i n = _mm_loadu_si128(reinterpret_cast<const __m128i*>(visits + kid));
+    int empty = _mm_movemask_ps(
+        _mm_castsi128_ps(_mm_cmpeq_epi32(n, _mm_setzero_si128())));
+    if (empty) return kid + __builtin_ctz(empty);
+
+    __m256d n4 = _mm256_cvtepi32_pd(n);  // visits stay far below 2^31
+    __m256d v4 = _mm256_mul_pd(revert4, _mm256_loadu_pd(value + kid));
+    v4 = _mm256_add_pd(v4, _mm256_mul_pd(explore4, _mm256_sqrt_pd(n4)));
+    v4 = _mm256_div_pd(v4, n4);
+
+    __m256d better = _mm256_cmp_pd(v4, best4, _CMP_GT_OQ);
+    best4 = _mm256_blendv_pd(best4, v4, better);
+    best_index4 = _mm256_blendv_pd(best_index4, index4, better);
+    index4 = _mm256_add_pd(index4, _mm256_set1_pd(4));
+  }
+  double lane_value[4], lane_index[4];
+  _mm256_storeu_pd(lane_value, best4);
+  _mm256_storeu_pd(lane_index, best_index4);
+  for (int lane = 0; lane < 4; ++lane) {
+    if (lane_value[lane] > best_value ||
+        (lane_value[lane] == best_value && lane_index[lane] < best_child)) {
+      best_value = lane_value[lane];
+      best_child = lane_index[lane];
+    }
+  }
+
+  return ucb_argmax_from(value, visits, kid, count, revert, explore,
+                         best_value, best_child);
+}
+#endif
+
+/**
+ * the index of the best of count UCB1 scores, revert * value / visits +
+ * explore / sqrt(visits), over contiguous statistics, or the first index
+ * without visits if there is one; ties go to the lower index
+ *
+ * the AVX2 version is picked at run time if the processor supports it, or
+ * else the kids are scored two at a time with SSE2 where the build has it
+ */
+inline size_t ucb_argmax(const double* value, const uint32_t* visits,
+                         size_t count, double revert, double explore) {
+#if defined(__AVX2__)
+  return ucb_argmax_avx2(value, visits, count, revert, explore);
+#else
+#if defined(__x86_64__) || defined(__i386__)
+  static const bool avx2 = __builtin_cpu_supports("avx2");
+  if (avx2) return ucb_argmax_avx2(value, visits, count, revert, explore);
+#endif
+
+  size_t kid = 0;
+  double best_value = -std::numeric_limits<double>::infinity();
+  size_t best_child = 0;
+
+#if defined(__SSE2__)
+  const __m128d revert2 = _mm_set1_pd(revert);
+  const __m128d explore2 = _mm_set1_pd(explore);
+  for (; kid + 2 <= count; kid += 2) {
+    if (visits[kid] == 0) return kid;
+    if (visits[kid + 1] == 0) return kid + 1;
+
+    __m128d n2 = _mm_set_pd(visits[kid + 1], visits[kid]);
+    __m128d v2 = _mm_mul_pd(revert2, _mm_loadu_pd(value + kid));
+    __m128d s2 = _mm_set_pd(VisitTables::InverseSqrt(visits[kid + 1]),
+                            VisitTables::InverseSqrt(visits[kid]));
+    v2 = _mm_add_pd(_mm_div_pd(v2, n2), _mm_mul_pd(explore2, s2));
+
+    double lane_value[2];
+    _mm_storeu_pd(lane_value, v2);
+    for (int lane = 0; lane < 2; ++lane) {
+      if (lane_value[lane] > best_value) {
+        best_value = lane_value[lane];
+        best_child = kid + lane;
+      }
+    }
+  }
+#endif
+
+  return ucb_argmax_from(value, visits, kid, count, revert, explore,
+                         best_value, best_child);
+#endif
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "ucb1.h"
+
+/**
+ * MC-RAVE, which blends the mean of a kid with its AMAF mean, so that kids
+ * without visits are ordered by their AMAF means, and only a kid that has
+ * neither is tried first
+ *
+ * by default beta = sqrt(k / (3n + k)) for the equivalence parameter k, the
+ * number of visits at which both means weigh the same; with a bias b, the
+ * minimum-MSE schedule beta = n' / (n + n' + 4b^2 n n') is used instead
+ */
+struct RAVE {
+  static constexpr bool kAmaf = true;
+
+  static double Beta(double visits, double amaf_visits,
+                     const SearchOptions& options) {
+    if (options.rave_bias > 0) {
+      double b = options.rave_bias;
+      double sum = visits + amaf_visits + 4 * b * b * visits * amaf_visits;
+      return sum > 0 ? amaf_visits / sum : 1.0;
+    }
+
+    return sqrt(options.rave / (3 * visits + options.rave));
+  }
+
+  template <class Game>
+  static NodeId Select(NodePool& pool, NodeId id, const Game& state,
+                       const SearchOptions& options) {
+    double revert_ = options.minmax ? -1.0 : 1.0;
+    const Node& node = pool[id];
+    const Node* kids = &pool[node.kids];
+
+    double l_explore = sqrt(2 * VisitTables::Log(pool.Visits(id).load()));
+    double best_value = -std::numeric_limits<double>::infinity();
+    size_t best_child = 0;
+
+    for (size_t kid = 0; kid < node.kid_count; ++kid) {
+      if (pool[node.kids + kid].proof == Node::kWin) continue;
+      uint32_t visits, shared;
+      double mean =
+          kid_mean(pool, node.kids + kid, state, options, visits, shared);
+
+      uint32_t amaf_visits =
+          kids[kid].amaf_visits.load(std::memory_order_relaxed);
+      if (std::max(visits, shared) == 0 && amaf_visits == 0) {
+        return node.kids + kid;
+      }
+      double amaf_mean =
+          amaf_visits
+              ? kids[kid].amaf_value.load(std::memory_order_relaxed) /
+                    amaf_visits
+              : 0.0;
+      double weight = amaf_visits ? Beta(visits, amaf_visits, options) : 0.0;
+
+      double v = revert_ * ((1 - weight) * mean + weight * amaf_mean) +
+                 l_explore * VisitTables::InverseSqrt(visits);
+
+      if (v > best_value) {
+        best_value = v;
+        best_child = kid;
+      }
+    }
+
+    return node.kids + best_child;
+  }
+};
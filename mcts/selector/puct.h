@@ -0,0 +1,39 @@
+#pragma once
+#include "ucb1.h"
+
+/**
+ * PUCT as in AlphaZero, mean + c * prior * sqrt(N) / (1 + n), where every
+ * kid has the same prior since there is no policy to give one; unlike UCB1,
+ * kids without visits are not forced first, they start at a mean of zero
+ */
+struct PUCT {
+  static constexpr bool kAmaf = false;
+
+  template <class Game>
+  static NodeId Select(NodePool& pool, NodeId id, const Game& state,
+                       const SearchOptions& options) {
+    double revert_ = options.minmax ? -1.0 : 1.0;
+    const Node& node = pool[id];
+
+    double l_explore =
+        options.c_puct * sqrt(pool.Visits(id).load()) / node.kid_count;
+    double best_value = -std::numeric_limits<double>::infinity();
+    size_t best_child = 0;
+
+    for (size_t kid = 0; kid < node.kid_count; ++kid) {
+      if (pool[node.kids + kid].proof == Node::kWin) continue;
+      uint32_t visits, shared;
+      double mean =
+          kid_mean(pool, node.kids + kid, state, options, visits, shared);
+
+      double v = (revert_ * mean) + (l_explore / (1 + visits));
+
+      if (v > best_value) {
+        best_value = v;
+        best_child = kid;
+      }
+    }
+
+    return node.kids + best_child;
+  }
+};
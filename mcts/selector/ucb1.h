@@ -0,0 +1,75 @@
+#pragma once
+#include <algorithm>
+#include <limits>
+
+#include "../mcts.h"
+#include "kernel.h"
+
+/**
+ * the visits and the mean of a kid, where the mean is taken from the
+ * transposition table if its position has been visited more often through
+ * all paths than through this node, and the visits seen through either
+ */
+template <class Game>
+double kid_mean(const NodePool& pool, NodeId kid, const Game& state,
+                const SearchOptions& options, uint32_t& visits,
+                uint32_t& shared) {
+  visits = pool.Visits(kid).load(std::memory_order_relaxed);
+  double mean =
+      visits ? pool.Value(kid).load(std::memory_order_relaxed) / visits : 0.0;
+
+  const TranspositionTable::Entry* entry = nullptr;
+  if (options.table) {
+    entry = options.table->Find(state.GetHashAfter(pool[kid].action));
+  }
+  shared = entry ? entry->visits.load(std::memory_order_relaxed) : 0;
+  if (shared > visits) {
+    mean = entry->value.load(std::memory_order_relaxed) / shared;
+  }
+
+  return mean;
+}
+
+/**
+ * the kid with the best upper confidence bound, trying every kid once first
+ *
+ * without a transposition table, the scores are computed by the vectorized
+ * kernel straight from the statistics arrays of the pool, unless some kids
+ * are proven to win, which are never selected
+ */
+struct UCB1 {
+  static constexpr bool kAmaf = false;  // whether AMAF statistics are used
+
+  template <class Game>
+  static NodeId Select(NodePool& pool, NodeId id, const Game& state,
+                       const SearchOptions& options) {
+    double revert_ = options.minmax ? -1.0 : 1.0;
+    const Node& node = pool[id];
+
+    double l_explore = sqrt(2 * VisitTables::Log(pool.Visits(id).load()));
+    if (!options.table && node.won_kids == 0) {
+      return node.kids + ucb_argmax(pool.Values(node.kids),
+                                    pool.VisitCounts(node.kids),
+                                    node.kid_count, revert_, l_explore);
+    }
+    double best_value = -std::numeric_limits<double>::infinity();
+    size_t best_child = 0;
+
+    for (size_t kid = 0; kid < node.kid_count; ++kid) {
+      if (pool[node.kids + kid].proof == Node::kWin) continue;
+      uint32_t visits, shared;
+      double mean =
+          kid_mean(pool, node.kids + kid, state, options, visits, shared);
+      if (std::max(visits, shared) == 0) return node.kids + kid;
+
+      double v = revert_ * mean + l_explore * VisitTables::InverseSqrt(visits);
+
+      if (v > best_value) {
+        best_value = v;
+        best_child = kid;
+      }
+    }
+
+    return node.kids + best_child;
+  }
+};
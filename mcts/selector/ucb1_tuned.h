@@ -0,0 +1,46 @@
+#pragma once
+#include "ucb1.h"
+
+/**
+ * UCB1-tuned, which scales the exploration of a kid by an upper bound on the
+ * variance of its rewards
+ *
+ * the rewards are wins and losses, so the variance follows from the mean as
+ * for a Bernoulli variable on [0, 1], and nodes keep no sum of squares
+ */
+struct UCB1Tuned {
+  static constexpr bool kAmaf = false;
+
+  template <class Game>
+  static NodeId Select(NodePool& pool, NodeId id, const Game& state,
+                       const SearchOptions& options) {
+    double revert_ = options.minmax ? -1.0 : 1.0;
+    const Node& node = pool[id];
+
+    double log_visits = VisitTables::Log(pool.Visits(id).load());
+    double best_value = -std::numeric_limits<double>::infinity();
+    size_t best_child = 0;
+
+    for (size_t kid = 0; kid < node.kid_count; ++kid) {
+      if (pool[node.kids + kid].proof == Node::kWin) continue;
+      uint32_t visits, shared;
+      double mean =
+          kid_mean(pool, node.kids + kid, state, options, visits, shared);
+      if (std::max(visits, shared) == 0) return node.kids + kid;
+
+      double n = std::max(visits, 1u);
+      double win = std::min(std::max((mean + 1) / 2, 0.0), 1.0);
+      double variance = win * (1 - win) + sqrt(2 * log_visits / n);
+      // rewards span [-1, 1], twice the range of the bound on [0, 1]
+      double v = (revert_ * mean) +
+                 2 * sqrt(log_visits / n * std::min(0.25, variance));
+
+      if (v > best_value) {
+        best_value = v;
+        best_child = kid;
+      }
+    }
+
+    return node.kids + best_child;
+  }
+};
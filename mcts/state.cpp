@@ -1,26 +1,32 @@
 #include "mcts.h"
 
-std::vector<int> NoGoState::GetPossibleActions() {
-  auto b_ = board_;
-  std::vector<int> actions;
-  actions.reserve(board::size_x * board::size_y);
-
-  for (int i = 0; i < board::size_x * board::size_y; ++i) {
-    auto after = b_;
-    auto move = action::place(i, b_.info().who_take_turns);
-    if (move.apply(after) == board::legal) actions.push_back(i);
-  }
-
-  return actions;
+ActionList NoGoState::GetPossibleActions() {
+  auto& moves = board_.legal_set();
+  return ActionList(moves.begin(), moves.end());
 }
 
 void NoGoState::ApplyAction(const int action) {
-  auto move = action::place(action, board_.info().who_take_turns);
-  if (move.apply(board_) != board::legal) {
+  assert(depth_ < history_.size());
+  if (depth_ == 0) origin_ = action_;
+  if (board_.make_move(action, history_[depth_]) != board::legal) {
     std::cerr << "Illegal action: " << action << std::endl;
     assert(false);
   }
 
+  depth_ += 1;
   action_ = action;
   reward_ = -reward_;
-}
\ No newline at end of file
+}
+
+void NoGoState::UndoAction() {
+  assert(depth_ > 0);
+  board_.unmake_move(history_[--depth_]);
+
+  action_ = depth_ ? history_[depth_ - 1].move : origin_;
+  reward_ = -reward_;
+}
+
+double NoGoState::Rollout(Random& engine, ActionSet* played) {
+  /* the side to move when the playout stops has lost */
+  return board_.playout(engine, played) % 2 ? 1.0 : -1.0;
+}
@@ -0,0 +1,49 @@
+#include "mcts.h"
+
+/**
+ * a table of as many buckets as fit in the given bytes, at least two
+ */
+TranspositionTable::TranspositionTable(size_t bytes) : mask_(1) {
+  while ((mask_ + 1) * 2 * 2 * sizeof(Entry) <= bytes) mask_ = mask_ * 2 + 1;
+  entries_.reset(new Entry[Size()]);
+  Clear();
+}
+
+const TranspositionTable::Entry* TranspositionTable::Find(
+    uint64_t key) const {
+  const Entry* bucket = &entries_[(key & mask_) * 2];
+  key = Tag(key);
+  if (bucket[0].key.load(std::memory_order_relaxed) == key) return &bucket[0];
+  if (bucket[1].key.load(std::memory_order_relaxed) == key) return &bucket[1];
+
+  return nullptr;
+}
+
+void TranspositionTable::Update(uint64_t key, double value) {
+  Entry* bucket = &entries_[(key & mask_) * 2];
+  key = Tag(key);
+  Entry* entry = &bucket[0];
+  if (bucket[0].key.load(std::memory_order_relaxed) != key) {
+    if (bucket[1].key.load(std::memory_order_relaxed) == key ||
+        bucket[1].visits.load(std::memory_order_relaxed) <
+            bucket[0].visits.load(std::memory_order_relaxed)) {
+      entry = &bucket[1];
+    }
+    if (entry->key.load(std::memory_order_relaxed) != key) {
+      entry->key.store(key, std::memory_order_relaxed);
+      entry->value.store(0, std::memory_order_relaxed);
+      entry->visits.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  atomic_add(entry->value, value);
+  entry->visits.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TranspositionTable::Clear() {
+  for (size_t i = 0; i < Size(); ++i) {
+    entries_[i].key.store(0, std::memory_order_relaxed);
+    entries_[i].value.store(0, std::memory_order_relaxed);
+    entries_[i].visits.store(0, std::memory_order_relaxed);
+  }
+}
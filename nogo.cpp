@@ -46,9 +46,9 @@ int main(int argc, const char* argv[]) {
     } else if (match_arg("limit")) {
       limit = std::stoull(next_opt());
     } else if (match_arg("black")) {
-      black_args = next_opt();
+      black_args = next_opt() + " ";  // kept apart from the name and role
     } else if (match_arg("white")) {
-      white_args = next_opt();
+      white_args = next_opt() + " ";
     } else if (match_arg("load")) {
       load_path = next_opt();
     } else if (match_arg("save")) {
@@ -158,7 +158,8 @@ int main(int argc, const char* argv[]) {
             std::cerr << "reason: " << reason[std::min(-code, 7)] << std::endl;
             break;
           }
-          who->notify_action(move);
+          black->notify_action(move);  // both, for the one that is pondering
+          white->notify_action(move);
         } else if (args[0] == "genmove") {  // generate a move and play
           action::place move = who->take_action(game.state());
           if (game.apply_action(move) == true) {
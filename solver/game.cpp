@@ -0,0 +1,136 @@
+#include "game.h"
+
+#include <algorithm>
+
+GameStore::GameStore(size_t budget) : budget_(budget) { Clear(); }
+
+void GameStore::Clear() {
+  forms_.clear();
+  index_.clear();
+  leq_.clear();
+  sum_.clear();
+  Intern({}, {});  // zero
+}
+
+GameId GameStore::Intern(const std::vector<GameId>& left,
+                         const std::vector<GameId>& right) {
+  auto key = std::make_pair(left, right);
+  auto it = index_.find(key);
+  if (it != index_.end()) return it->second;
+
+  GameId id = forms_.size();
+  forms_.push_back({left, right});
+  index_.emplace(std::move(key), id);
+  return id;
+}
+
+/**
+ * g <= h unless some left option of g is >= h, or some right option of h is
+ * <= g
+ */
+bool GameStore::Leq(GameId g, GameId h) {
+  if (g == h) return true;
+  uint64_t key = uint64_t(g) << 32 | h;
+  auto it = leq_.find(key);
+  if (it != leq_.end()) return it->second;
+
+  bool leq = true;
+  for (size_t k = 0; leq && k < forms_[g].left.size(); ++k) {
+    leq = !Leq(h, forms_[g].left[k]);
+  }
+  for (size_t k = 0; leq && k < forms_[h].right.size(); ++k) {
+    leq = !Leq(forms_[h].right[k], g);
+  }
+
+  leq_[key] = leq;
+  return leq;
+}
+
+/**
+ * drop the left options that are <= another one, or the right options that
+ * are >= another one, keeping one of equal options
+ */
+void GameStore::RemoveDominated(std::vector<GameId>& options, bool left) {
+  std::sort(options.begin(), options.end());
+  options.erase(std::unique(options.begin(), options.end()), options.end());
+
+  std::vector<GameId> kept;
+  for (size_t a = 0; a < options.size(); ++a) {
+    bool dominated = false;
+    for (size_t b = 0; !dominated && b < options.size(); ++b) {
+      if (a == b) continue;
+      bool worse = left ? Leq(options[a], options[b])
+                        : Leq(options[b], options[a]);
+      // of two equal options, the one found later is kept
+      bool equal = worse && (left ? Leq(options[b], options[a])
+                                  : Leq(options[a], options[b]));
+      dominated = worse && (!equal || a < b);
+    }
+    if (!dominated) kept.push_back(options[a]);
+  }
+  options.swap(kept);
+}
+
+/**
+ * the canonical form of { left | right }, where the options are canonical:
+ * dominated options are dropped, and reversible options are bypassed, that
+ * is, a left option with a right option that is <= the game is replaced by
+ * the left options of that right option, and the other way around
+ */
+GameId GameStore::Make(std::vector<GameId> left, std::vector<GameId> right) {
+  if (Exhausted()) return Zero();
+
+  for (bool changed = true; changed;) {
+    changed = false;
+    RemoveDominated(left, true);
+    RemoveDominated(right, false);
+    GameId g = Intern(left, right);
+
+    for (size_t k = 0; !changed && k < left.size(); ++k) {
+      for (GameId reply : forms_[left[k]].right) {
+        if (!Leq(reply, g)) continue;
+        std::vector<GameId> bypass = forms_[reply].left;
+        left.erase(left.begin() + k);
+        left.insert(left.end(), bypass.begin(), bypass.end());
+        changed = true;
+        break;
+      }
+    }
+    for (size_t k = 0; !changed && k < right.size(); ++k) {
+      for (GameId reply : forms_[right[k]].left) {
+        if (!Leq(g, reply)) continue;
+        std::vector<GameId> bypass = forms_[reply].right;
+        right.erase(right.begin() + k);
+        right.insert(right.end(), bypass.begin(), bypass.end());
+        changed = true;
+        break;
+      }
+    }
+  }
+
+  return Intern(left, right);
+}
+
+/**
+ * g + h = { gL + h, g + hL | gR + h, g + hR }
+ */
+GameId GameStore::Add(GameId g, GameId h) {
+  if (g == Zero()) return h;
+  if (h == Zero()) return g;
+  if (g > h) std::swap(g, h);
+  uint64_t key = uint64_t(g) << 32 | h;
+  auto it = sum_.find(key);
+  if (it != sum_.end()) return it->second;
+
+  // copies, as the sums below may grow the store
+  Form a = forms_[g], b = forms_[h];
+  std::vector<GameId> left, right;
+  for (GameId option : a.left) left.push_back(Add(option, h));
+  for (GameId option : b.left) left.push_back(Add(g, option));
+  for (GameId option : a.right) right.push_back(Add(option, h));
+  for (GameId option : b.right) right.push_back(Add(g, option));
+
+  GameId sum = Make(left, right);
+  sum_[key] = sum;
+  return sum;
+}
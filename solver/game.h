@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * index of a short partizan game in a GameStore
+ */
+using GameId = uint32_t;
+
+/**
+ * short partizan games in canonical form, as in combinatorial game theory,
+ * where a game is given by the games its Left (black) and Right (white)
+ * options lead to, and the sum of independent games is played by moving in
+ * any one of them; under normal play, the side that cannot move loses
+ *
+ * every game built by Make() is simplified to its canonical form, which is
+ * unique, so equal games share one id; comparisons and sums are memoized
+ *
+ * a store keeps every game it has built, up to a budget, past which it is
+ * exhausted and its results must not be used until Clear()
+ */
+class GameStore {
+ public:
+  explicit GameStore(size_t budget = size_t(1) << 20);
+
+  GameId Zero() const { return 0; }  // { | }, the game without moves
+  GameId Make(std::vector<GameId> left, std::vector<GameId> right);
+  GameId Add(GameId, GameId);
+  bool Leq(GameId, GameId);  // whether g <= h, Right wins h - g going first
+
+  /**
+   * whether Left wins going first, which is the case unless g <= 0, and
+   * whether Left wins going second, which is the case if g >= 0
+   */
+  bool LeftFirstWins(GameId g) { return !Leq(g, Zero()); }
+  bool LeftSecondWins(GameId g) { return Leq(Zero(), g); }
+
+  bool Exhausted() const { return forms_.size() > budget_; }
+  size_t Size() const { return forms_.size(); }
+  void Clear();
+
+ private:
+  struct Form {
+    std::vector<GameId> left, right;
+  };
+
+  GameId Intern(const std::vector<GameId>& left,
+                const std::vector<GameId>& right);
+  void RemoveDominated(std::vector<GameId>& options, bool left);
+
+  std::vector<Form> forms_;
+  std::map<std::pair<std::vector<GameId>, std::vector<GameId>>, GameId>
+      index_;
+  std::unordered_map<uint64_t, bool> leq_;
+  std::unordered_map<uint64_t, GameId> sum_;
+  size_t budget_;
+};
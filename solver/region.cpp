@@ -0,0 +1,175 @@
+#include "region.h"
+
+namespace {
+
+typedef board::bitboard bitboard;
+
+constexpr unsigned kCells = board::size_x * board::size_y;
+
+/**
+ * the key of a cell of a region (0), a black (1) or white (2) stone, or an
+ * empty cell that is out of play (3), apart from the keys of the board
+ */
+uint64_t CellKey(unsigned what, int i) {
+  return board::geometry::splitmix64((what + 3) * kCells + i + 1);
+}
+
+/**
+ * the blocks of either color that have a stone next to the cells
+ */
+bitboard Blocks(const board& b, bitboard cells) {
+  bitboard near = board::neighbors(cells);
+  bitboard black = b.mask(board::black), white = b.mask(board::white);
+  return board::flood(near & black, black) | board::flood(near & white, white);
+}
+
+}  // namespace
+
+RegionSolver::RegionSolver(int max_region, size_t limit, size_t budget)
+    : games_(budget),
+      max_region_(max_region),
+      limit_(limit),
+      valued_(0),
+      timed_(false),
+      aborted_(false) {}
+
+void RegionSolver::Clear() {
+  games_.Clear();
+  memo_.clear();
+}
+
+/**
+ * the regions of the cells of area that either side can still play
+ */
+std::vector<RegionSolver::bitboard> RegionSolver::Split(
+    const board& b, bitboard area) const {
+  bitboard live = area & (b.legal_moves(board::black) |
+                          b.legal_moves(board::white));
+  std::vector<bitboard> regions;
+  while (live) {
+    bitboard region = live & -live;
+    for (bitboard last = 0; last != region;) {
+      last = region;
+      region |= (board::neighbors(region) |
+                 board::neighbors(Blocks(b, region))) & live;
+    }
+    regions.push_back(region);
+    live &= ~region;
+  }
+  return regions;
+}
+
+/**
+ * the key of the region with the blocks next to it and the empty cells next
+ * to either, which are all that the legality of its moves depends on
+ */
+uint64_t RegionSolver::Key(const board& b, bitboard region) const {
+  bitboard blocks = Blocks(b, region);
+  bitboard out = board::neighbors(region | blocks) &
+                 b.mask(board::empty) & ~region;
+  uint64_t key = 0;
+  for (bitboard c = region; c; c &= c - 1) key ^= CellKey(0, board::lowest(c));
+  for (bitboard c = blocks; c; c &= c - 1) {
+    int i = board::lowest(c);
+    key ^= CellKey(b.mask(board::black) & board::bit(i) ? 1 : 2, i);
+  }
+  for (bitboard c = out; c; c &= c - 1) key ^= CellKey(3, board::lowest(c));
+  return key;
+}
+
+/**
+ * the sum of the values of the regions of area
+ */
+GameId RegionSolver::Sum(board& b, bitboard area) {
+  GameId sum = games_.Zero();
+  for (bitboard region : Split(b, area))
+    sum = games_.Add(sum, Value(b, region));
+  return sum;
+}
+
+/**
+ * the value of a single region, { the black moves | the white moves }
+ */
+GameId RegionSolver::Value(board& b, bitboard region) {
+  uint64_t key = Key(b, region);
+  auto it = memo_.find(key);
+  if (it != memo_.end()) return it->second;
+  if (++valued_ > limit_) aborted_ = true;
+  if ((valued_ & 1023) == 0 && timed_ &&
+      std::chrono::steady_clock::now() >= deadline_)
+    aborted_ = true;
+  if (aborted_) return games_.Zero();
+
+  board::data turn = b.info();
+  std::vector<GameId> options[2];
+  for (unsigned who : {board::black, board::white}) {
+    b.info({board::piece_type(who)});
+    for (bitboard m = b.legal_moves(who) & region; m; m &= m - 1) {
+      int i = board::lowest(m);
+      board::undo record;
+      b.make_move(i, record, who);
+      options[who - 1].push_back(Sum(b, region & ~board::bit(i)));
+      b.unmake_move(record);
+    }
+  }
+  b.info(turn);
+
+  GameId value = games_.Make(options[0], options[1]);
+  if (!games_.Exhausted() && !aborted_) memo_[key] = value;
+  return value;
+}
+
+/**
+ * solve the position for the side to move if all its regions are small
+ * enough, and find a move that leaves a sum the opponent loses going first
+ */
+RegionSolver::Result RegionSolver::Solve(const board& state, int timeout) {
+  Result result = {false, false, -1};
+  valued_ = 0;
+  timed_ = timeout > 0;
+  deadline_ =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+  aborted_ = false;
+  board b = state;
+  std::vector<bitboard> regions = Split(b, board::full());
+  for (bitboard region : regions)
+    if (board::count(region) > max_region_) return result;
+
+  std::vector<GameId> values;
+  GameId total = games_.Zero();
+  for (bitboard region : regions) {
+    values.push_back(Value(b, region));
+    total = games_.Add(total, values.back());
+  }
+  if (games_.Exhausted() || aborted_) {
+    if (games_.Exhausted()) Clear();
+    return result;
+  }
+
+  unsigned who = b.info().who_take_turns;
+  bool black = who == board::black;
+  result.win = black ? games_.LeftFirstWins(total)
+                     : !games_.LeftSecondWins(total);
+  for (size_t r = 0; result.win && result.move == -1 && r < regions.size();
+       r++) {
+    GameId rest = games_.Zero();
+    for (size_t k = 0; k < regions.size(); k++)
+      if (k != r) rest = games_.Add(rest, values[k]);
+    for (bitboard m = b.legal_moves(who) & regions[r]; m; m &= m - 1) {
+      int i = board::lowest(m);
+      board::undo record;
+      b.make_move(i, record, who);
+      GameId after = games_.Add(rest, Sum(b, regions[r] & ~board::bit(i)));
+      b.unmake_move(record);
+      if (black ? games_.LeftSecondWins(after)
+                : !games_.LeftFirstWins(after)) {
+        result.move = i;
+        break;
+      }
+    }
+  }
+
+  result.solved = !games_.Exhausted();
+  if (!result.solved) Clear();
+  return result;
+}
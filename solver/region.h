@@ -0,0 +1,65 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "../board.h"
+#include "game.h"
+
+/**
+ * endgame solver that splits a NoGo position into independent regions and
+ * adds up their values as combinatorial games
+ *
+ * a move changes the legality of only its neighbors and the liberties of the
+ * blocks next to it, so two cells are linked if they are adjacent or are
+ * liberties of the same block; the cells that neither side can play stay
+ * empty forever, since in NoGo a cell never becomes legal again, and are left
+ * out, so the rest falls apart into regions that no move can affect across
+ *
+ * the last player to move wins NoGo, which is the normal play convention, so
+ * the position is the sum of its regions, where each region is valued by the
+ * games its black and white moves lead to, and each of those is again the sum
+ * of the regions the move splits the region into; the values are memoized by
+ * a key of the region and everything around it that its moves depend on
+ */
+class RegionSolver {
+ public:
+  typedef board::bitboard bitboard;
+
+  struct Result {
+    bool solved;  // false if a region is too large, or the limits were hit
+    bool win;     // whether the side to move wins
+    int move;     // a winning move, or -1
+  };
+
+  /**
+   * regions of more than max_region cells are not tried, and a solve gives
+   * up after valuing limit region positions, or once the store holds budget
+   * games
+   */
+  explicit RegionSolver(int max_region = 12, size_t limit = size_t(1) << 19,
+                        size_t budget = size_t(1) << 20);
+
+  /**
+   * solve the position, giving up after timeout milliseconds if positive
+   */
+  Result Solve(const board&, int timeout = 0);
+  void Clear();
+
+ private:
+  GameId Value(board&, bitboard region);
+  GameId Sum(board&, bitboard area);
+  std::vector<bitboard> Split(const board&, bitboard area) const;
+  uint64_t Key(const board&, bitboard region) const;
+
+  GameStore games_;
+  std::unordered_map<uint64_t, GameId> memo_;
+  int max_region_;
+  size_t limit_;
+  size_t valued_;  // the region positions valued by the current solve
+
+  std::chrono::steady_clock::time_point deadline_;
+  bool timed_;
+  bool aborted_;  // once the limit or the deadline is hit
+};
@@ -0,0 +1,158 @@
+#include "solver.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+Solver::Solver(size_t bytes) : mask_(0), history_() {
+  size_t size = 1;
+  while (size * 2 * sizeof(Entry) <= bytes) size *= 2;
+  table_.reset(new Entry[size]);
+  mask_ = size - 1;
+  Clear();
+}
+
+void Solver::Clear() {
+  std::fill(table_.get(), table_.get() + mask_ + 1, Entry());
+  for (auto& side : history_) side.fill(0);
+}
+
+Solver::Result Solver::Search(const board& state, int depth, int timeout) {
+  timed_ = timeout > 0;
+  deadline_ =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+  aborted_ = false;
+  nodes_ = 0;
+
+  Result result = {0, -1, 0, false, 0};
+  if (state.legal_set().empty()) {
+    result.score = -kWin;
+    result.proven = true;
+    return result;
+  }
+  result.move = state.legal_set()[0];
+
+  board b = state;
+  /* to the end of the game, every score is a proof, so deepening gains
+     nothing but the move ordering, which costs more than it saves */
+  int first = depth > 0 ? 1 : kMaxPlies, limit = depth > 0 ? depth : kMaxPlies;
+  for (int d = first; d <= limit; ++d) {
+    int score = Negamax(b, d, -kWin, kWin, 0);
+    if (aborted_) break;
+
+    result.score = score;
+    result.move = root_move_;
+    result.depth = d;
+    result.proven = std::abs(score) == kWin;
+    if (result.proven) break;
+  }
+  result.nodes = nodes_;
+
+  return result;
+}
+
+int Solver::Negamax(board& b, int depth, int alpha, int beta, int ply) {
+  if ((++nodes_ & 4095) == 0 && TimeUp()) aborted_ = true;
+  if (aborted_) return 0;
+
+  auto& legal = b.legal_set();
+  if (legal.empty()) return -kWin;  // the side to move has lost
+
+  uint64_t key = b.hash();
+  const Entry& entry = table_[key & mask_];
+  int tt_move = -1;
+  if (entry.key == key) {
+    tt_move = entry.move;
+    int score = entry.score;
+    if (entry.depth >= depth && ply > 0) {  // the root must give a move
+      if (entry.bound == kExact) return score;
+      if (entry.bound == kLower && score >= beta) return score;
+      if (entry.bound == kUpper && score <= alpha) return score;
+    }
+  }
+  if (depth == 0) return Evaluate(b);
+
+  uint8_t moves[kMaxPlies];
+  int count = Order(b, tt_move, moves);
+  unsigned who = b.info().who_take_turns;
+  int original_alpha = alpha;
+  int best = -kWin, best_move = moves[0];
+  for (int k = 0; k < count; ++k) {
+    board::undo record;
+    b.make_move(board::point(moves[k]), record);
+    int score = -Negamax(b, depth - 1, -beta, -alpha, ply + 1);
+    b.unmake_move(record);
+    if (aborted_) return 0;
+
+    if (score > best) {
+      best = score;
+      best_move = moves[k];
+    }
+    if (score > alpha) alpha = score;
+    if (alpha >= beta) {
+      history_[who - 1][moves[k]] += depth * depth;
+      break;
+    }
+  }
+
+  Bound bound = best <= original_alpha ? kUpper
+                : best >= beta         ? kLower
+                                       : kExact;
+  Store(key, best, best_move, depth, bound);
+  if (ply == 0) root_move_ = best_move;
+  return best;
+}
+
+/**
+ * the difference in the numbers of legal moves, as the side that runs out of
+ * moves first loses
+ */
+int Solver::Evaluate(const board& b) const {
+  unsigned who = b.info().who_take_turns;
+  return int(b.legal_set(who).size()) - int(b.legal_set(3u - who).size());
+}
+
+/**
+ * fill moves with the legal moves in the order to search them, and return
+ * their number
+ */
+int Solver::Order(const board& b, int tt_move, uint8_t* moves) const {
+  unsigned who = b.info().who_take_turns;
+  auto& legal = b.legal_set(who);
+  board::bitboard contested = b.legal_moves(3u - who);
+  const auto& history = history_[who - 1];
+
+  uint64_t keys[kMaxPlies];
+  int count = 0;
+  for (int move : legal) {
+    uint64_t key = history[move];
+    if (contested & board::bit(move)) key |= uint64_t(1) << 32;
+    if (move == tt_move) key |= uint64_t(1) << 33;
+    int k = count++;
+    for (; k > 0 && keys[k - 1] < key; --k) {  // insertion, best first
+      keys[k] = keys[k - 1];
+      moves[k] = moves[k - 1];
+    }
+    keys[k] = key;
+    moves[k] = move;
+  }
+
+  return count;
+}
+
+void Solver::Store(uint64_t key, int score, int move, int depth,
+                   Bound bound) {
+  if (score == kWin && bound != kUpper) depth = kMaxPlies + 1;
+  if (score == -kWin && bound != kLower) depth = kMaxPlies + 1;
+
+  Entry& entry = table_[key & mask_];
+  if (entry.key == key && entry.depth > depth) return;
+  entry.key = key;
+  entry.score = score;
+  entry.move = move;
+  entry.depth = depth;
+  entry.bound = bound;
+}
+
+bool Solver::TimeUp() {
+  return timed_ && std::chrono::steady_clock::now() >= deadline_;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include "../board.h"
+
+/**
+ * negamax alpha-beta search of NoGo positions with a transposition table,
+ * deepened one ply at a time, which solves a position exactly when it is
+ * searched to the end of the game
+ *
+ * the moves come from the legal sets that the board keeps as bitboards, and
+ * are made and taken back in place; they are ordered by the move stored in
+ * the table, then by whether the opponent could also play there, since the
+ * cells only one side can play are safe to keep for later, and then by a
+ * history of the moves that caused cutoffs
+ *
+ * scores are from the view of the side to move: kWin for a proven win, -kWin
+ * for a proven loss, and the difference in the numbers of legal moves of both
+ * sides at the depth limit; the length of a win does not matter, so the first
+ * win found at a node cuts off its other moves
+ */
+class Solver {
+ public:
+  static constexpr int kWin = 10000;
+  static constexpr int kMaxPlies = board::size_x * board::size_y;
+
+  struct Result {
+    int score;
+    int move;     // -1 if there is no legal move
+    int depth;    // of the last completed iteration
+    bool proven;  // whether the score is the exact result of the game
+    uint64_t nodes;
+  };
+
+  explicit Solver(size_t bytes = size_t(16) << 20);
+
+  /**
+   * search the position one ply deeper at a time up to the given depth, or
+   * only once to the end of the game if 0, stopping early once the result is
+   * proven, and giving up after timeout milliseconds if it is positive; the
+   * result of the deepest completed iteration is returned
+   */
+  Result Search(const board&, int depth = 0, int timeout = 0);
+  void Clear();
+
+ private:
+  enum Bound : uint8_t { kNone, kExact, kLower, kUpper };
+  struct Entry {
+    uint64_t key;
+    int16_t score;
+    int8_t move;
+    uint8_t depth;  // kMaxPlies + 1 for proven scores, valid at any depth
+    uint8_t bound;
+  };
+
+  int Negamax(board&, int depth, int alpha, int beta, int ply);
+  int Evaluate(const board&) const;
+  int Order(const board&, int tt_move, uint8_t* moves) const;
+  void Store(uint64_t key, int score, int move, int depth, Bound bound);
+  bool TimeUp();
+
+  std::unique_ptr<Entry[]> table_;
+  size_t mask_;
+  std::array<std::array<uint32_t, kMaxPlies>, 2> history_;  // piece_type - 1
+
+  std::chrono::steady_clock::time_point deadline_;
+  bool timed_;
+  bool aborted_;
+  uint64_t nodes_;
+  int root_move_;  // the best move of the last search of the root
+};